@@ -0,0 +1,31 @@
+/**
+ * arena.c - Bump allocation from one zeroed heap block
+ */
+
+#include "arena.h"
+
+#include <stdlib.h>
+
+#define ARENA_ALIGNMENT sizeof(uintptr_t)
+
+bool arena_init(Arena *arena, size_t size) {
+  *arena = (Arena) {
+    .base = calloc(1, size),
+    .size = size,
+  };
+  return arena->base != NULL;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+  const size_t offset = (arena->used + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+  if(!arena->base || offset + size > arena->size) {
+    return NULL;
+  }
+  arena->used = offset + size;
+  return arena->base + offset;
+}
+
+void arena_release(Arena *arena) {
+  free(arena->base);
+  *arena = (Arena) { 0 };
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * arena.h - Fixed-size bump allocator. Everything is carved out of a single
+ * heap block and released together, so short-lived groups of allocations
+ * don't fragment the heap.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint8_t *base;
+  size_t size;
+  size_t used;
+} Arena;
+
+// Allocate the backing block, zeroed, returning false if the heap is too small
+bool arena_init(Arena *arena, size_t size);
+
+// Carve out word-aligned memory, or NULL once the arena is exhausted
+void *arena_alloc(Arena *arena, size_t size);
+
+// Free the backing block and everything allocated from it
+void arena_release(Arena *arena);
@@ -0,0 +1,128 @@
+/**
+ * benchmark.c - Times ActionMenu open and close using app_timer to step
+ * through the iterations
+ */
+
+#include "benchmark.h"
+
+#include "time_util.h"
+
+#if BENCHMARK_MENU
+
+// Let the main Window settle before the first iteration
+#define START_DELAY_MS 1000
+
+// How long each menu stays open, long enough for the open animation to finish
+#define HOLD_MS 600
+
+#if defined(PBL_PLATFORM_APLITE)
+#define PLATFORM_NAME "aplite"
+#elif defined(PBL_PLATFORM_BASALT)
+#define PLATFORM_NAME "basalt"
+#elif defined(PBL_PLATFORM_CHALK)
+#define PLATFORM_NAME "chalk"
+#else
+#define PLATFORM_NAME "unknown"
+#endif
+
+static BenchmarkOpenHandler s_open_handler;
+static BenchmarkCloseHandler s_close_handler;
+static uint32_t s_open_samples[BENCHMARK_MENU_ITERATIONS];
+static uint32_t s_close_samples[BENCHMARK_MENU_ITERATIONS];
+static uint32_t s_draw_samples[BENCHMARK_MENU_ITERATIONS];
+static int s_num_draw_samples;
+static int s_iteration = -1;
+static uint64_t s_start_ms;
+static uint64_t s_draw_start_ms;
+
+static void sort_samples(uint32_t *samples, int count) {
+  for(int i = 1; i < count; i++) {
+    const uint32_t value = samples[i];
+    int j = i - 1;
+    for(; j >= 0 && samples[j] > value; j--) {
+      samples[j + 1] = samples[j];
+    }
+    samples[j + 1] = value;
+  }
+}
+
+static void log_stats(const char *name, uint32_t *samples, int count) {
+  sort_samples(samples, count);
+  const int p95_index = (count * 95 + 99) / 100 - 1;
+  APP_LOG(APP_LOG_LEVEL_INFO, "bench: %s %s n=%d min=%ums median=%ums p95=%ums",
+          PLATFORM_NAME, name, count, (unsigned)samples[0], (unsigned)samples[count / 2],
+          (unsigned)samples[p95_index]);
+}
+
+static void finish(int num_iterations) {
+  if(num_iterations > 0) {
+    log_stats("open", s_open_samples, num_iterations);
+    log_stats("close", s_close_samples, num_iterations);
+  }
+  if(s_num_draw_samples > 0) {
+    log_stats("draw", s_draw_samples, s_num_draw_samples);
+  }
+  s_iteration = -1;
+}
+
+static void close_timer_callback(void *context) {
+  s_start_ms = time_util_now_ms();
+  s_close_handler();
+}
+
+static void opened_timer_callback(void *context) {
+  // The first turn of the event loop after opening, the menu Window is loaded
+  s_open_samples[s_iteration] = time_util_now_ms() - s_start_ms;
+  app_timer_register(HOLD_MS, close_timer_callback, NULL);
+}
+
+static void open_timer_callback(void *context) {
+  s_start_ms = time_util_now_ms();
+  if(!s_open_handler()) {
+    // did_close will never come, so stop with what has been measured
+    APP_LOG(APP_LOG_LEVEL_ERROR, "bench: %s open failed at iteration %d, %u bytes free", PLATFORM_NAME,
+            s_iteration, (unsigned)heap_bytes_free());
+    finish(s_iteration);
+    return;
+  }
+  app_timer_register(0, opened_timer_callback, NULL);
+}
+
+void benchmark_start(BenchmarkOpenHandler open_handler, BenchmarkCloseHandler close_handler) {
+  s_open_handler = open_handler;
+  s_close_handler = close_handler;
+  s_iteration = 0;
+  s_num_draw_samples = 0;
+  app_timer_register(START_DELAY_MS, open_timer_callback, NULL);
+}
+
+void benchmark_menu_did_close() {
+  if(s_iteration < 0) {
+    return;
+  }
+
+  s_close_samples[s_iteration] = time_util_now_ms() - s_start_ms;
+  if(++s_iteration == BENCHMARK_MENU_ITERATIONS) {
+    finish(BENCHMARK_MENU_ITERATIONS);
+  } else {
+    app_timer_register(HOLD_MS, open_timer_callback, NULL);
+  }
+}
+
+void benchmark_draw_begin() {
+  s_draw_start_ms = time_util_now_ms();
+}
+
+void benchmark_draw_end() {
+  // Each close redraws the main Window, so expect about one draw per iteration
+  if(s_iteration >= 0 && s_num_draw_samples < BENCHMARK_MENU_ITERATIONS) {
+    s_draw_samples[s_num_draw_samples++] = time_util_now_ms() - s_draw_start_ms;
+  }
+}
+
+void benchmark_layout_end() {
+  APP_LOG(APP_LOG_LEVEL_INFO, "bench: %s layout %ums", PLATFORM_NAME,
+          (unsigned)(time_util_now_ms() - s_draw_start_ms));
+}
+
+#endif
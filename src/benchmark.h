@@ -0,0 +1,50 @@
+#pragma once
+
+/**
+ * benchmark.h - Optional ActionMenu open/close latency benchmark, enabled with
+ * BENCHMARK_MENU in config.h. At launch the menu is opened and closed a number
+ * of times and the min/median/p95 latencies are logged for the platform,
+ * along with the time taken to draw the main Window's label on each return.
+ */
+
+#include <pebble.h>
+
+#include "config.h"
+
+// Returns false if the menu couldn't be opened
+typedef bool (*BenchmarkOpenHandler)(void);
+typedef void (*BenchmarkCloseHandler)(void);
+
+#if BENCHMARK_MENU
+
+#define BENCHMARK_START(open, close) benchmark_start(open, close)
+#define BENCHMARK_MENU_DID_CLOSE() benchmark_menu_did_close()
+#define BENCHMARK_DRAW_BEGIN() benchmark_draw_begin()
+#define BENCHMARK_DRAW_END() benchmark_draw_end()
+#define BENCHMARK_LAYOUT_BEGIN() benchmark_draw_begin()
+#define BENCHMARK_LAYOUT_END() benchmark_layout_end()
+
+// Drive the menu with the given handlers until all iterations have run, or
+// until the menu fails to open
+void benchmark_start(BenchmarkOpenHandler open_handler, BenchmarkCloseHandler close_handler);
+
+// Call from the ActionMenu's did_close handler
+void benchmark_menu_did_close(void);
+
+// Bracket a draw, only recorded while the benchmark is running
+void benchmark_draw_begin(void);
+void benchmark_draw_end(void);
+
+// Log the time since benchmark_draw_begin as a one-off layout cost
+void benchmark_layout_end(void);
+
+#else
+
+#define BENCHMARK_START(open, close)
+#define BENCHMARK_MENU_DID_CLOSE()
+#define BENCHMARK_DRAW_BEGIN()
+#define BENCHMARK_DRAW_END()
+#define BENCHMARK_LAYOUT_BEGIN()
+#define BENCHMARK_LAYOUT_END()
+
+#endif
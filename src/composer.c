@@ -0,0 +1,89 @@
+/**
+ * composer.c - Segment budget accounting for composed patterns
+ */
+
+#include "composer.h"
+
+static bool ends_with_pulse(const Composer *composer) {
+  return composer->num_segments % 2 == 1;
+}
+
+static ComposerResult check_budget(uint32_t num_segments, uint32_t total_ms) {
+  if(num_segments > COMPOSER_MAX_SEGMENTS) {
+    return ComposerResultTooManySegments;
+  }
+  if(total_ms > COMPOSER_MAX_DURATION_MS) {
+    return ComposerResultTooLong;
+  }
+  return ComposerResultOk;
+}
+
+static ComposerResult extend(Composer *composer, bool pulse) {
+  // Consecutive primitives of the same phase lengthen the last segment
+  const bool append = (ends_with_pulse(composer) != pulse);
+  const uint32_t num_segments = composer->num_segments + (append ? 1 : 0);
+  const ComposerResult result = check_budget(num_segments, composer->total_ms + COMPOSER_STEP_MS);
+  if(result != ComposerResultOk) {
+    return result;
+  }
+
+  if(append) {
+    composer->segments[composer->num_segments++] = COMPOSER_STEP_MS;
+  } else {
+    composer->segments[composer->num_segments - 1] += COMPOSER_STEP_MS;
+  }
+  composer->total_ms += COMPOSER_STEP_MS;
+  return ComposerResultOk;
+}
+
+void composer_clear(Composer *composer) {
+  *composer = (Composer) { .num_segments = 0 };
+}
+
+ComposerResult composer_add_pulse(Composer *composer) {
+  return extend(composer, true);
+}
+
+ComposerResult composer_add_gap(Composer *composer) {
+  // A pattern can't start with a gap
+  if(composer->num_segments == 0) {
+    return ComposerResultEmpty;
+  }
+  return extend(composer, false);
+}
+
+ComposerResult composer_repeat(Composer *composer) {
+  if(composer->num_segments == 0) {
+    return ComposerResultEmpty;
+  }
+
+  // The copy starts with a pulse, so a pattern ending in one needs a gap first
+  const bool needs_gap = ends_with_pulse(composer);
+  const uint32_t length = composer->num_segments;
+  const uint32_t num_segments = 2 * length + (needs_gap ? 1 : 0);
+  const uint32_t total_ms = 2 * composer->total_ms + (needs_gap ? COMPOSER_STEP_MS : 0);
+  const ComposerResult result = check_budget(num_segments, total_ms);
+  if(result != ComposerResultOk) {
+    return result;
+  }
+
+  if(needs_gap) {
+    composer->segments[composer->num_segments++] = COMPOSER_STEP_MS;
+  }
+  for(uint32_t i = 0; i < length; i++) {
+    composer->segments[composer->num_segments++] = composer->segments[i];
+  }
+  composer->total_ms = total_ms;
+  return ComposerResultOk;
+}
+
+ComposerResult composer_get_pattern(const Composer *composer, const uint32_t **segments,
+                                    uint32_t *num_segments) {
+  if(composer->num_segments == 0) {
+    return ComposerResultEmpty;
+  }
+
+  *segments = composer->segments;
+  *num_segments = composer->num_segments - (ends_with_pulse(composer) ? 0 : 1);
+  return check_budget(composer->num_segments, composer->total_ms);
+}
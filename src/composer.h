@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * composer.h - Builds a custom vibration pattern from pulse, gap and repeat
+ * primitives. Every edit is checked against the segment and duration budget
+ * first, so a pattern is never truncated when it is enqueued.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Conservative limits for one vibes_enqueue_custom_pattern() call
+#define COMPOSER_MAX_SEGMENTS 16
+#define COMPOSER_MAX_DURATION_MS 10000
+
+// Length a pulse or gap primitive adds
+#define COMPOSER_STEP_MS 100
+
+typedef enum {
+  ComposerResultOk,
+  ComposerResultEmpty,
+  ComposerResultTooManySegments,
+  ComposerResultTooLong
+} ComposerResult;
+
+// Segments alternate on and off, starting with on
+typedef struct {
+  uint32_t segments[COMPOSER_MAX_SEGMENTS];
+  uint32_t num_segments;
+  uint32_t total_ms;
+} Composer;
+
+void composer_clear(Composer *composer);
+ComposerResult composer_add_pulse(Composer *composer);
+ComposerResult composer_add_gap(Composer *composer);
+
+// Append a copy of everything so far, separated by a gap if needed
+ComposerResult composer_repeat(Composer *composer);
+
+// Segments to enqueue, leaving out a trailing gap which would only waste a slot
+ComposerResult composer_get_pattern(const Composer *composer, const uint32_t **segments,
+                                    uint32_t *num_segments);
@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+ * config.h - Compile-time switches for the optional modes. All of them are
+ * off by default and compile away entirely when disabled. Each switch can
+ * also be set for one build, e.g. APP_DEFINES="DEBUG_HEAP=1" pebble build
+ */
+
+// Log heap and stack usage across the ActionMenu lifecycle, and show the peak
+// in a corner of the main Window
+#ifndef DEBUG_HEAP
+#define DEBUG_HEAP 0
+#endif
+
+// Repeatedly open and close the ActionMenu at launch and log latency stats
+#ifndef BENCHMARK_MENU
+#define BENCHMARK_MENU 0
+#endif
+#define BENCHMARK_MENU_ITERATIONS 20
+
+// Repeatedly open/close the menu and unload/reload the main Window at launch,
+// logging any change in heap usage between cycles
+#ifndef STRESS_LIFECYCLE
+#define STRESS_LIFECYCLE 0
+#endif
+#define STRESS_LIFECYCLE_CYCLES 200
+
+// Build and tear down randomly generated menu definitions at launch, logging
+// heap drift and any level whose capacity doesn't match the items added
+#ifndef FUZZ_MENU
+#define FUZZ_MENU 0
+#endif
+#ifndef FUZZ_MENU_ITERATIONS
+#define FUZZ_MENU_ITERATIONS 500
+#endif
+#ifndef FUZZ_MENU_SEED
+#define FUZZ_MENU_SEED 1
+#endif
+
+// Scale vibrations down when the battery is low and not charging, falling back
+// to single pulses when nearly empty, and label actions with their motor time
+#ifndef BATTERY_SAVER
+#define BATTERY_SAVER 0
+#endif
+#define BATTERY_SAVER_REDUCED_PERCENT 30
+#define BATTERY_SAVER_MINIMAL_PERCENT 10
+#define BATTERY_SAVER_SCALE_PERCENT 50
+
+// Log the main Window's draw time per frame, counting frames that miss the
+// animation rate around ActionMenu transitions, with a summary at exit
+#ifndef PROFILE_FRAMES
+#define PROFILE_FRAMES 0
+#endif
+
+// Timestamp clicks, ActionMenu actions and vibes in a ring buffer, logging the
+// latency of each click to vibe. The buffer is dumped at exit, and on demand
+// by the DumpTrace command once it is added to the menu definition.
+#ifndef TRACE_LATENCY
+#define TRACE_LATENCY 0
+#endif
+#define TRACE_LATENCY_EVENTS 32
+
+// How choosing an action finishes the menu: the vibe plays as it animates
+// closed, once it has finished closing, or as it closes without animating
+#define MENU_COMMIT_ANIMATED 0
+#define MENU_COMMIT_AFTER_CLOSE 1
+#define MENU_COMMIT_UNANIMATED 2
+#ifndef MENU_COMMIT
+#define MENU_COMMIT MENU_COMMIT_ANIMATED
+#endif
+
+// Below this much free heap at launch the app runs on its low memory tier,
+// with a smaller font, no icons and flattened menu levels
+#ifndef MEMORY_LOW_TIER_FREE_BYTES
+#define MEMORY_LOW_TIER_FREE_BYTES 12000
+#endif
@@ -0,0 +1,67 @@
+/**
+ * heap_debug.c - Heap and stack usage sampling with a peak usage overlay
+ */
+
+#include "heap_debug.h"
+
+#if DEBUG_HEAP
+
+#define OVERLAY_HEIGHT 18
+
+static uintptr_t s_stack_base;
+static size_t s_peak_heap, s_peak_stack;
+
+static TextLayer *s_overlay_layer;
+static char s_overlay_text[24];
+
+static void update_overlay() {
+  if(s_overlay_layer) {
+    snprintf(s_overlay_text, sizeof(s_overlay_text), "peak %uB", (unsigned)s_peak_heap);
+    text_layer_set_text(s_overlay_layer, s_overlay_text);
+  }
+}
+
+void heap_debug_init(const void *stack_base) {
+  s_stack_base = (uintptr_t)stack_base;
+  s_peak_heap = 0;
+  s_peak_stack = 0;
+}
+
+void heap_debug_sample(const char *event) {
+  // The stack grows down, so depth is measured from the base recorded in main()
+  char marker;
+  const size_t stack = s_stack_base ? s_stack_base - (uintptr_t)&marker : 0;
+  const size_t used = heap_bytes_used();
+  const size_t available = heap_bytes_free();
+
+  if(used > s_peak_heap) {
+    s_peak_heap = used;
+  }
+  if(stack > s_peak_stack) {
+    s_peak_stack = stack;
+  }
+
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "heap: %s used=%u free=%u peak=%u stack=%u peak_stack=%u",
+          event, (unsigned)used, (unsigned)available, (unsigned)s_peak_heap,
+          (unsigned)stack, (unsigned)s_peak_stack);
+  update_overlay();
+}
+
+void heap_debug_attach(Layer *parent) {
+  GRect bounds = layer_get_bounds(parent);
+
+  s_overlay_layer = text_layer_create(GRect(0, bounds.size.h - OVERLAY_HEIGHT, bounds.size.w, OVERLAY_HEIGHT));
+  text_layer_set_font(s_overlay_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+  text_layer_set_text_color(s_overlay_layer, GColorBlack);
+  text_layer_set_background_color(s_overlay_layer, GColorClear);
+  text_layer_set_text_alignment(s_overlay_layer, PBL_IF_ROUND_ELSE(GTextAlignmentCenter, GTextAlignmentLeft));
+  layer_add_child(parent, text_layer_get_layer(s_overlay_layer));
+  update_overlay();
+}
+
+void heap_debug_detach() {
+  text_layer_destroy(s_overlay_layer);
+  s_overlay_layer = NULL;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * heap_debug.h - Optional heap and stack instrumentation, enabled with
+ * DEBUG_HEAP in config.h. Each sample logs the current usage and tracks the
+ * peak seen so far, which can be shown in an overlay on any Layer.
+ */
+
+#include <pebble.h>
+
+#include "config.h"
+
+#if DEBUG_HEAP
+
+// Record the approximate stack base, call this first thing in main()
+#define HEAP_DEBUG_INIT() do { char base; heap_debug_init(&base); } while(0)
+#define HEAP_DEBUG_SAMPLE(event) heap_debug_sample(event)
+#define HEAP_DEBUG_ATTACH(parent) heap_debug_attach(parent)
+#define HEAP_DEBUG_DETACH() heap_debug_detach()
+
+void heap_debug_init(const void *stack_base);
+void heap_debug_sample(const char *event);
+void heap_debug_attach(Layer *parent);
+void heap_debug_detach(void);
+
+#else
+
+#define HEAP_DEBUG_INIT()
+#define HEAP_DEBUG_SAMPLE(event)
+#define HEAP_DEBUG_ATTACH(parent)
+#define HEAP_DEBUG_DETACH()
+
+#endif
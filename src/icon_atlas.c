@@ -0,0 +1,47 @@
+/**
+ * icon_atlas.c - Cuts the atlas strip into sub-bitmaps in ICONS order
+ */
+
+#include "icon_atlas.h"
+
+#define ICON_SIZE(name, width, height) [Icon##name] = { width, height },
+
+static const GSize s_icon_sizes[IconCount] = {
+  ICONS(ICON_SIZE)
+};
+
+static GBitmap *s_atlas;
+static GBitmap *s_icons[IconCount];
+
+void icon_atlas_init() {
+  s_atlas = gbitmap_create_with_resource(RESOURCE_ID_ICON_ATLAS);
+  if(!s_atlas) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Icon atlas failed to load");
+    return;
+  }
+
+  // Icons sit side by side, top aligned, as packed by tools/pack_icons.py
+  int16_t x = 0;
+  for(int i = 0; i < IconCount; i++) {
+    s_icons[i] = gbitmap_create_as_sub_bitmap(s_atlas, GRect(x, 0, s_icon_sizes[i].w, s_icon_sizes[i].h));
+    x += s_icon_sizes[i].w;
+  }
+}
+
+void icon_atlas_deinit() {
+  // Sub-bitmaps only borrow the atlas's pixels, so go before it
+  for(int i = 0; i < IconCount; i++) {
+    if(s_icons[i]) {
+      gbitmap_destroy(s_icons[i]);
+      s_icons[i] = NULL;
+    }
+  }
+  if(s_atlas) {
+    gbitmap_destroy(s_atlas);
+    s_atlas = NULL;
+  }
+}
+
+GBitmap *icon_atlas_get(Icon icon) {
+  return (icon < IconCount) ? s_icons[icon] : NULL;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * icon_atlas.h - Loads the ICON_ATLAS resource once and hands out sub-bitmaps
+ * of it, which share the atlas's pixels, so Windows can come and go without
+ * reading or decoding their icons again.
+ */
+
+#include <pebble.h>
+
+#include "icons.h"
+
+// Load the atlas, call before any Window using icons is pushed
+void icon_atlas_init(void);
+
+// Release the atlas, every bitmap handed out becomes invalid
+void icon_atlas_deinit(void);
+
+// The icon's bitmap, owned by the atlas, or NULL if it failed to load
+GBitmap *icon_atlas_get(Icon icon);
@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * icons.h - The single list of icons in the ICON_ATLAS resource. The atlas is
+ * a horizontal strip of these in order, built from resources/icons/ by
+ * tools/pack_icons.py, which reads this list for the order and sizes.
+ *
+ * Columns: name, width, height
+ */
+
+#define ICONS(X) \
+  X(Ellipsis, 16, 4)
+
+#define ICON_ENUM(name, width, height) Icon##name,
+
+typedef enum {
+  ICONS(ICON_ENUM)
+
+  IconCount
+} Icon;
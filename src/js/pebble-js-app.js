@@ -0,0 +1,223 @@
+/**
+ * pebble-js-app.js - Pushes the menu definition to the watch. The tree is
+ * packed in the same layout as tools/pack_menu.py produces, and only the level
+ * records the watch asks for are sent, several to a message.
+ *
+ * The definition is read from localStorage 'menu' (JSON, as in
+ * resources/menu.json) and falls back to DEFAULT_MENU.
+ *
+ * VIBRATION_TYPES and MENU_COMMANDS are generated from the C headers by
+ * tools/gen_js_names.py, and bundled alongside this file by the wscript.
+ */
+
+var MENU_MAGIC = [0x41, 0x4d];
+var MENU_VERSION = 1;
+var KIND_ACTION = 0;
+var KIND_CHILD = 1;
+var KIND_COMMAND = 2;
+
+// Former names of renamed commands, so menus stored under them still load
+var RENAMED_COMMANDS = {
+  RepeatLast: 'Every60s'
+};
+
+// The watch inbox is 512 bytes, leave room for the dictionary overhead
+var MAX_BATCH_BYTES = 480;
+var MAX_LEVELS = 120;
+
+var DEFAULT_MENU = {
+  items: [
+    { type: 'Short' },
+    { type: 'Long' },
+    { type: 'Double' },
+    { label: 'Custom Pattern', items: [
+      { type: 'CustomShort' },
+      { type: 'CustomMedium' },
+      { type: 'CustomLong' }
+    ]},
+    { label: 'Compose', items: [
+      { command: 'ComposePulse' },
+      { command: 'ComposeGap' },
+      { command: 'ComposeRepeat' },
+      { command: 'ComposePlay' },
+      { command: 'ComposeClear' }
+    ]},
+    { label: 'Schedule', items: [
+      { command: 'Every10s' },
+      { command: 'Every30s' },
+      { command: 'Every60s' },
+      { command: 'In1Minute' },
+      { command: 'In5Minutes' },
+      { command: 'StopRepeating' }
+    ]},
+    { label: 'Shortcuts', items: [
+      { command: 'AssignUp' },
+      { command: 'AssignUpLong' },
+      { command: 'AssignDown' },
+      { command: 'AssignDownLong' }
+    ]}
+  ]
+};
+
+var s_records = [];
+var s_version = 0;
+
+function fnv1a(bytes, seed) {
+  var hash = (seed === undefined) ? 2166136261 : seed;
+  for (var i = 0; i < bytes.length; i++) {
+    hash ^= bytes[i];
+    hash = Math.imul(hash, 16777619) >>> 0;
+  }
+  return hash >>> 0;
+}
+
+function uint32Bytes(value) {
+  return [value & 0xff, (value >>> 8) & 0xff, (value >>> 16) & 0xff, (value >>> 24) & 0xff];
+}
+
+function utf8Bytes(text) {
+  var encoded = unescape(encodeURIComponent(text));
+  var bytes = [];
+  for (var i = 0; i < encoded.length; i++) {
+    bytes.push(encoded.charCodeAt(i));
+  }
+  return bytes;
+}
+
+// Children are packed before their parent, so the root is the last record
+function packLevel(level, records) {
+  var items = level.items;
+  if (items.length === 0 || items.length > 255) {
+    throw new Error('a level must have between 1 and 255 items');
+  }
+
+  var record = [items.length];
+  items.forEach(function(item) {
+    // Unlabelled actions and commands use their default label on the watch
+    var label = item.label ? utf8Bytes(item.label).concat([0]) : [];
+    if (label.length > 255) {
+      throw new Error('label too long: ' + item.label);
+    }
+    if (item.items && label.length === 0) {
+      throw new Error('child levels need a label');
+    }
+
+    var kind, value;
+    if (item.items) {
+      kind = KIND_CHILD;
+      value = packLevel(item, records);
+    } else if (item.command) {
+      kind = KIND_COMMAND;
+      value = MENU_COMMANDS.indexOf(RENAMED_COMMANDS[item.command] || item.command);
+      if (value < 0) {
+        throw new Error('unknown command: ' + item.command);
+      }
+    } else {
+      kind = KIND_ACTION;
+      value = VIBRATION_TYPES.indexOf(item.type);
+      if (value < 0) {
+        throw new Error('unknown vibration type: ' + item.type);
+      }
+    }
+    record = record.concat([kind, value, label.length], label);
+  });
+
+  records.push(record);
+  if (records.length > MAX_LEVELS) {
+    throw new Error('too many levels');
+  }
+  return records.length - 1;
+}
+
+function loadMenu() {
+  var stored = localStorage.getItem('menu');
+  var menu = DEFAULT_MENU;
+  if (stored) {
+    try {
+      menu = JSON.parse(stored);
+    } catch (e) {
+      console.log('Ignoring stored menu: ' + e.message);
+    }
+  }
+
+  s_records = [];
+  packLevel(menu, s_records);
+
+  var hashes = [];
+  s_records.forEach(function(record) {
+    hashes = hashes.concat(uint32Bytes(fnv1a(record)));
+  });
+  s_version = fnv1a(hashes);
+  return hashes;
+}
+
+function sendManifest() {
+  var hashes;
+  try {
+    hashes = loadMenu();
+  } catch (e) {
+    console.log('Invalid menu definition: ' + e.message);
+    return;
+  }
+
+  // Integers go over as int32, the watch reads the same bits back as uint32
+  Pebble.sendAppMessage({
+    'MenuVersion': s_version | 0,
+    'MenuLevelHashes': hashes
+  }, null, function() {
+    console.log('Failed to send menu manifest');
+  });
+}
+
+function sendBatches(batches) {
+  if (batches.length === 0) {
+    return;
+  }
+
+  // One message in flight at a time, the next is sent once this is acked
+  Pebble.sendAppMessage({
+    'MenuVersion': s_version | 0,
+    'MenuLevels': batches[0]
+  }, function() {
+    sendBatches(batches.slice(1));
+  }, function() {
+    console.log('Failed to send menu levels');
+  });
+}
+
+function sendNeeded(needed) {
+  var batches = [];
+  var batch = [];
+  for (var index = 0; index < s_records.length; index++) {
+    if (!(needed[index >> 3] & (1 << (index & 7)))) {
+      continue;
+    }
+
+    var record = s_records[index];
+    var entry = [index, record.length & 0xff, record.length >> 8].concat(record);
+    if (entry.length > MAX_BATCH_BYTES) {
+      console.log('Menu level ' + index + ' is too large to send');
+      return;
+    }
+    if (batch.length + entry.length > MAX_BATCH_BYTES) {
+      batches.push(batch);
+      batch = [];
+    }
+    batch = batch.concat(entry);
+  }
+  if (batch.length > 0) {
+    batches.push(batch);
+  }
+  sendBatches(batches);
+}
+
+Pebble.addEventListener('ready', function() {
+  sendManifest();
+});
+
+Pebble.addEventListener('appmessage', function(e) {
+  var payload = e.payload;
+  if (payload.MenuNeeded !== undefined && (payload.MenuVersion >>> 0) === s_version) {
+    sendNeeded(payload.MenuNeeded);
+  }
+});
@@ -0,0 +1,185 @@
+/**
+ * label_layer.c - Greedy word wrapping into per-line boxes, measured with the
+ * text layout engine once up front instead of on every redraw
+ */
+
+#include "label_layer.h"
+
+#include "benchmark.h"
+#include "profiler.h"
+
+#define LABEL_MAX_LINES 8
+
+// Distance kept from the edge of a round display, as for screen text flow
+#define LABEL_ROUND_INSET 3
+
+// Wide enough that measuring a candidate line never wraps it
+#define LABEL_MEASURE_WIDTH 1000
+
+typedef struct {
+  const char *text;
+  GRect box;
+} LabelLine;
+
+typedef struct {
+  GFont font;
+  uint8_t num_lines;
+  LabelLine lines[LABEL_MAX_LINES];
+  char text[];                 // Copy of the text, split in place into lines
+} LabelLayerData;
+
+/*********************************** Layout ***********************************/
+
+#if defined(PBL_ROUND)
+static int32_t isqrt(int32_t value) {
+  int32_t root = 0;
+  while((root + 1) * (root + 1) <= value) {
+    root++;
+  }
+  return root;
+}
+#endif
+
+static void get_row_span(GRect frame, GRect screen, int16_t y, int16_t height, int16_t *x, int16_t *width) {
+  // The horizontal run of the frame a line can use at this height, in frame coordinates
+  int16_t left = frame.origin.x;
+  int16_t right = frame.origin.x + frame.size.w;
+#if defined(PBL_ROUND)
+  // Keep both corners of the line inside the circle
+  const int32_t radius = screen.size.w / 2 - LABEL_ROUND_INSET;
+  const int32_t center_x = screen.origin.x + screen.size.w / 2;
+  const int32_t center_y = screen.origin.y + screen.size.h / 2;
+  const int32_t top = frame.origin.y + y - center_y;
+  const int32_t bottom = top + height;
+  // Whichever edge of the line is further from the centre limits its width
+  const int32_t dy = (top + bottom < 0) ? -top : bottom;
+  const int32_t half_width = (dy < radius) ? isqrt(radius * radius - dy * dy) : 0;
+  if(center_x - half_width > left) {
+    left = center_x - half_width;
+  }
+  if(center_x + half_width < right) {
+    right = center_x + half_width;
+  }
+#endif
+  *x = left - frame.origin.x;
+  *width = (right > left) ? right - left : 0;
+}
+
+static int16_t measure_width(const char *text, GFont font) {
+  return graphics_text_layout_get_content_size(text, font, GRect(0, 0, LABEL_MEASURE_WIDTH, LABEL_MEASURE_WIDTH),
+                                               GTextOverflowModeWordWrap, GTextAlignmentLeft).w;
+}
+
+static char *find_word_end(char *cursor) {
+  while(*cursor && *cursor != ' ') {
+    cursor++;
+  }
+  return cursor;
+}
+
+static char *fit_line(char *line, GFont font, int16_t width) {
+  // The end of the most words that fit, or NULL if not even the first does
+  char *fitted = NULL;
+  char *end = find_word_end(line);
+  while(true) {
+    const char next = *end;
+    *end = '\0';
+    const bool fits = measure_width(line, font) <= width;
+    *end = next;
+    if(!fits) {
+      break;
+    }
+    fitted = end;
+    if(next == '\0') {
+      break;
+    }
+    end = find_word_end(end + 1);
+  }
+  return fitted;
+}
+
+static void layout(LabelLayerData *data, GRect frame, GRect screen) {
+  const int16_t line_height = graphics_text_layout_get_content_size(
+      "Ag", data->font, GRect(0, 0, LABEL_MEASURE_WIDTH, LABEL_MEASURE_WIDTH),
+      GTextOverflowModeWordWrap, GTextAlignmentLeft).h;
+  if(line_height <= 0) {
+    return;
+  }
+
+  char *cursor = data->text;
+  for(int16_t y = 0; data->num_lines < LABEL_MAX_LINES && y + line_height <= frame.size.h; y += line_height) {
+    while(*cursor == ' ') {
+      cursor++;
+    }
+    if(*cursor == '\0') {
+      break;
+    }
+
+    int16_t x, width;
+    get_row_span(frame, screen, y, line_height, &x, &width);
+    char *end = fit_line(cursor, data->font, width);
+    if(!end) {
+      if(width < frame.size.w) {
+        // Narrowed by the screen edge, try further down
+        continue;
+      }
+      // Too long for any line, let it overflow rather than lose it
+      end = find_word_end(cursor);
+    }
+
+    const bool is_last = (*end == '\0');
+    *end = '\0';
+    data->lines[data->num_lines++] = (LabelLine) {
+      .text = cursor,
+      .box = GRect(x, y, width, line_height),
+    };
+    if(is_last) {
+      break;
+    }
+    cursor = end + 1;
+  }
+}
+
+/*********************************** Layer ************************************/
+
+static void update_proc(Layer *layer, GContext *ctx) {
+  BENCHMARK_DRAW_BEGIN();
+  PROFILE_DRAW_BEGIN();
+  const LabelLayerData *data = layer_get_data(layer);
+  graphics_context_set_text_color(ctx, GColorBlack);
+  for(int i = 0; i < data->num_lines; i++) {
+    graphics_draw_text(ctx, data->lines[i].text, data->font, data->lines[i].box,
+                       GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+  }
+  PROFILE_DRAW_END();
+  BENCHMARK_DRAW_END();
+}
+
+Layer *label_layer_create(GRect frame, GRect screen, const char *text, GFont font) {
+  const size_t text_size = strlen(text) + 1;
+  Layer *layer = layer_create_with_data(frame, sizeof(LabelLayerData) + text_size);
+  if(!layer) {
+    return NULL;
+  }
+
+  BENCHMARK_LAYOUT_BEGIN();
+  LabelLayerData *data = layer_get_data(layer);
+  data->font = font;
+  data->num_lines = 0;
+  memcpy(data->text, text, text_size);
+  layout(data, frame, screen);
+  BENCHMARK_LAYOUT_END();
+
+  layer_set_update_proc(layer, update_proc);
+  return layer;
+}
+
+void label_layer_destroy(Layer *layer) {
+  layer_destroy(layer);
+}
+
+GRect label_layer_get_line_box(GRect frame, GRect screen) {
+  int16_t x, width;
+  get_row_span(frame, screen, 0, frame.size.h, &x, &width);
+  return GRect(frame.origin.x + x, frame.origin.y, width, frame.size.h);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+ * label_layer.h - A Layer showing static text whose line breaks are worked out
+ * once when it is created, following the screen edge on round displays, so a
+ * redraw only draws the lines already laid out.
+ */
+
+#include <pebble.h>
+
+// Lay out text centred in the frame. The screen is the frame's parent bounds,
+// and is used to fit lines inside the display on round watches.
+Layer *label_layer_create(GRect frame, GRect screen, const char *text, GFont font);
+
+void label_layer_destroy(Layer *layer);
+
+// The part of a one line frame inside the display, for other text to line up
+// with the label's edges on round watches
+GRect label_layer_get_line_box(GRect frame, GRect screen);
@@ -6,106 +6,341 @@
 
 #include <pebble.h>
 
-typedef enum {
-  VibrationTypeShort,
-  VibrationTypeLong,
-  VibrationTypeDouble,
-  VibrationTypeCustomShort,
-  VibrationTypeCustomMedium,
-  VibrationTypeCustomLong
-} VibrationType;
+#include "benchmark.h"
+#include "composer.h"
+#include "config.h"
+#include "heap_debug.h"
+#include "icon_atlas.h"
+#include "label_layer.h"
+#include "menu.h"
+#include "menu_fuzz.h"
+#include "pattern.h"
+#include "persist_keys.h"
+#include "profiler.h"
+#include "shortcuts.h"
+#include "status_layer.h"
+#include "stress.h"
+#include "trace.h"
+#include "vibe_worker.h"
+#include "vibration_types.h"
 
 typedef struct {
   VibrationType type;
 } Context;
 
+typedef struct {
+  void (*play)(void);          // System pattern, if NULL the spec is played
+  PatternSpec spec;
+} VibrationPattern;
+
+// Chosen at launch from the free heap, the low tier trades looks for memory
+typedef enum {
+  MemoryTierFull,
+  MemoryTierLow,
+} MemoryTier;
+
+// A launch by the worker only plays its jobs, checked this often until they finish
+#define WORKER_LAUNCH_LINGER_MS 3000
+
+// Choices are written to flash once they stop coming, and at exit
+#define SAVE_DELAY_MS 5000
+
+// The status line sits under the label. On round displays it is raised to
+// where the circle is wide enough for the longest type label.
+#define STATUS_HEIGHT 24
+#define STATUS_MARGIN PBL_IF_ROUND_ELSE(24, 4)
+
+#define VIBRATION_TYPE_PATTERN(name, label, play_fn, on, off, count) \
+  [VibrationType##name] = { .play = play_fn, .spec = { .on_ms = on, .off_ms = off, .repeat = count } },
+
+// Every VibrationType's pattern, looked up when an action is performed
+static const VibrationPattern s_vibration_patterns[VibrationTypeCount] = {
+  VIBRATION_TYPES(VIBRATION_TYPE_PATTERN)
+};
+
 static Window *s_main_window;
-static TextLayer *s_label_layer;
+static Layer *s_label_layer;
+static Layer *s_status_layer;
 static ActionBarLayer *s_action_bar;
 
-static GBitmap *s_ellipsis_bitmap;
-static VibrationType s_current_type;
+static MemoryTier s_memory_tier;
+static VibrationType s_current_type = VibrationTypeCount;
+static uint16_t s_usage_counts[VibrationTypeCount];
+static VibrationType s_saved_type = VibrationTypeCount;
+static bool s_usage_changed;
+static AppTimer *s_save_timer;
+
+static Composer s_composer;
+
+#if BATTERY_SAVER
+// Motor on-time of each type at the current battery level, shown in the menu
+static uint16_t s_vibration_costs[VibrationTypeCount];
+#endif
+
+/********************************* Vibration **********************************/
+
+static void play_pattern_spec(const PatternSpec *spec) {
+  // The vibe driver copies each segment into its queue, so a stack buffer will do
+  uint32_t segments[PATTERN_MAX_SEGMENTS];
+  const uint32_t num_segments = pattern_expand(spec, segments, ARRAY_LENGTH(segments));
+  if(num_segments > 0) {
+    vibes_enqueue_custom_pattern((VibePattern) {
+      .durations = segments,
+      .num_segments = num_segments,
+    });
+  }
+}
+
+static PatternPower get_vibe_power() {
+#if BATTERY_SAVER
+  const BatteryChargeState charge = battery_state_service_peek();
+  if(!charge.is_charging && !charge.is_plugged) {
+    if(charge.charge_percent <= BATTERY_SAVER_MINIMAL_PERCENT) {
+      return PatternPowerMinimal;
+    }
+    if(charge.charge_percent <= BATTERY_SAVER_REDUCED_PERCENT) {
+      return PatternPowerReduced;
+    }
+  }
+#endif
+  return PatternPowerFull;
+}
+
+static bool get_scaled_spec(VibrationType type, PatternPower power, PatternSpec *spec) {
+  // Returns false when the system pattern should be played as it is
+  const VibrationPattern *pattern = &s_vibration_patterns[type];
+  *spec = pattern_scale(&pattern->spec, power, BATTERY_SAVER_SCALE_PERCENT);
+  return power != PatternPowerFull || !pattern->play;
+}
+
+#if BATTERY_SAVER
+static void update_vibration_costs() {
+  // Energy goes on the motor, so its total on-time stands in for the cost
+  const PatternPower power = get_vibe_power();
+  for(int type = 0; type < VibrationTypeCount; type++) {
+    PatternSpec spec;
+    get_scaled_spec(type, power, &spec);
+    uint32_t segments[PATTERN_MAX_SEGMENTS];
+    const uint32_t num_segments = pattern_expand(&spec, segments, ARRAY_LENGTH(segments));
+    const uint32_t on_ms = pattern_on_time_ms(segments, num_segments);
+    s_vibration_costs[type] = (on_ms < UINT16_MAX) ? on_ms : UINT16_MAX;
+  }
+}
+#endif
+
+static void play_vibration(VibrationType type) {
+  TRACE_EVENT(TraceEventVibe);
+  PatternSpec spec;
+  if(get_scaled_spec(type, get_vibe_power(), &spec)) {
+    play_pattern_spec(&spec);
+  } else {
+    s_vibration_patterns[type].play();
+  }
+}
+
+static uint32_t play_worker_vibration(VibrationType type) {
+  // How long it lasts, so the next job due with it waits its turn
+  PatternSpec spec;
+  get_scaled_spec(type, get_vibe_power(), &spec);
+  uint32_t segments[PATTERN_MAX_SEGMENTS];
+  const uint32_t num_segments = pattern_expand(&spec, segments, ARRAY_LENGTH(segments));
+  play_vibration(type);
+  return pattern_duration_ms(segments, num_segments);
+}
+
+static void save_choices() {
+  // Only touch flash for what changed since the last save
+  s_save_timer = NULL;
+  if(s_current_type != s_saved_type) {
+    s_saved_type = s_current_type;
+    persist_write_int(PersistKeyLastType, s_current_type);
+  }
+  if(s_usage_changed) {
+    s_usage_changed = false;
+    persist_write_data(PersistKeyUsageCounts, s_usage_counts, sizeof(s_usage_counts));
+  }
+}
+
+static void save_timer_callback(void *context) {
+  save_choices();
+}
+
+static void count_usage(VibrationType type) {
+  // Halve everything rather than saturate, so recent habits still count
+  if(s_usage_counts[type] == UINT16_MAX) {
+    for(int i = 0; i < VibrationTypeCount; i++) {
+      s_usage_counts[i] /= 2;
+    }
+  }
+  s_usage_counts[type]++;
+  s_usage_changed = true;
+}
 
-static ActionMenu *s_action_menu;
-static ActionMenuLevel *s_root_level, *s_custom_level;
+static void choose_vibration(VibrationType type) {
+  // An action was selected from the ActionMenu or a button shortcut
+  HEAP_DEBUG_SAMPLE("action");
+
+  // Play this vibration before any bookkeeping, so nothing delays it
+  play_vibration(type);
+
+  // Remember it for replaying, saved once the choices settle
+  s_current_type = type;
+  count_usage(type);
+  status_layer_set_type(s_status_layer, s_current_type);
+  if(!s_save_timer || !app_timer_reschedule(s_save_timer, SAVE_DELAY_MS)) {
+    s_save_timer = app_timer_register(SAVE_DELAY_MS, save_timer_callback, NULL);
+  }
+}
+
+static bool play_composed_pattern() {
+  const uint32_t *segments;
+  uint32_t num_segments;
+  const ComposerResult result = composer_get_pattern(&s_composer, &segments, &num_segments);
+  if(result != ComposerResultOk) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Composed pattern not played (%d)", result);
+    return false;
+  }
+
+  TRACE_EVENT(TraceEventVibe);
+  vibes_enqueue_custom_pattern((VibePattern) {
+    .durations = segments,
+    .num_segments = num_segments,
+  });
+  return true;
+}
 
 /********************************* ActionMenu *********************************/
 
-static void action_performed_callback(ActionMenu *action_menu, const ActionMenuItem *action, void *context) {
-  // An action was selected, determine which one
-  s_current_type = (VibrationType)action_menu_item_get_action_data(action);
-
-  // Play this vibration
-  static uint32_t segments[5];
-  switch(s_current_type) {
-    case VibrationTypeShort:  vibes_short_pulse();  break;
-    case VibrationTypeLong:   vibes_long_pulse();   break;
-    case VibrationTypeDouble: vibes_double_pulse(); break;
-    default:
-      // Create the patten
-      for(int i = 0; i < 5; i++) {
-        switch(s_current_type) {
-          case VibrationTypeCustomShort:  segments[i] = i * 100; break;
-          case VibrationTypeCustomMedium: segments[i] = i * 200; break;
-          case VibrationTypeCustomLong:   segments[i] = i * 300; break;
-          default: break;
-        }
-      }
-
-      // Play the custom pattern
-      VibePattern pat = {
-        .durations = segments,
-        .num_segments = ARRAY_LENGTH(segments),
-      };
-      vibes_enqueue_custom_pattern(pat);
-      break;
-  }
-}
-
-static void init_action_menu() {
-  // Create the root level
-  s_root_level = action_menu_level_create(4);
-
-  // Set up the actions for this level, using action context to pass types
-  action_menu_level_add_action(s_root_level, "Short", action_performed_callback, 
-                              (void *)VibrationTypeShort);
-  action_menu_level_add_action(s_root_level, "Long", action_performed_callback, 
-                               (void *)VibrationTypeLong);
-  action_menu_level_add_action(s_root_level, "Double", action_performed_callback, 
-                               (void *)VibrationTypeDouble);
-  
-  // Create and set up the secondary level, adding it as a child to the root one
-  s_custom_level = action_menu_level_create(3);
-  action_menu_level_add_child(s_root_level, s_custom_level, "Custom Pattern");
-
-  // Set up the secondary actions
-  action_menu_level_add_action(s_custom_level, "Custom Fast", action_performed_callback, 
-                               (void *)VibrationTypeCustomShort);
-  action_menu_level_add_action(s_custom_level, "Custom Medium", action_performed_callback, 
-                               (void *)VibrationTypeCustomMedium);
-  action_menu_level_add_action(s_custom_level, "Custom Slow", action_performed_callback, 
-                               (void *)VibrationTypeCustomLong);
+static bool compose_command(MenuCommand command) {
+  // Edits keep the composer level open so the pattern can be built up
+  ComposerResult result = ComposerResultOk;
+  switch(command) {
+    case MenuCommandComposePulse:  result = composer_add_pulse(&s_composer); break;
+    case MenuCommandComposeGap:    result = composer_add_gap(&s_composer);   break;
+    case MenuCommandComposeRepeat: result = composer_repeat(&s_composer);    break;
+    case MenuCommandComposeClear:  composer_clear(&s_composer);              break;
+    case MenuCommandComposePlay:   return !play_composed_pattern();
+    default: return false;
+  }
+
+  if(result != ComposerResultOk) {
+    // Over budget, say so with a buzz rather than dropping the edit silently
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Composer edit rejected (%d)", result);
+    vibes_short_pulse();
+  }
+  return true;
+}
+
+static void schedule_current_type(uint16_t interval_s, uint16_t count) {
+  // Nothing to schedule until a type has been chosen
+  if(s_current_type < VibrationTypeCount) {
+    vibe_worker_repeat(s_current_type, interval_s, count);
+  } else {
+    vibes_short_pulse();
+  }
+}
+
+static void assign_shortcut(Shortcut shortcut) {
+  // Nothing to assign until a type has been chosen
+  if(s_current_type < VibrationTypeCount) {
+    shortcuts_set(shortcut, s_current_type);
+  } else {
+    vibes_short_pulse();
+  }
+}
+
+static void dump_trace() {
+  // Only does anything in a traced build, where it can be added to the menu
+#if TRACE_LATENCY
+  TRACE_DUMP();
+#else
+  APP_LOG(APP_LOG_LEVEL_INFO, "Latency tracing is off, build with TRACE_LATENCY=1");
+#endif
+}
+
+static bool menu_command_handler(MenuCommand command) {
+  switch(command) {
+    case MenuCommandEvery10s:       schedule_current_type(10, 0);      return false;
+    case MenuCommandEvery30s:       schedule_current_type(30, 0);      return false;
+    case MenuCommandEvery60s:       schedule_current_type(60, 0);      return false;
+    case MenuCommandIn1Minute:      schedule_current_type(60, 1);      return false;
+    case MenuCommandIn5Minutes:     schedule_current_type(5 * 60, 1);  return false;
+    case MenuCommandStopRepeating:  vibe_worker_cancel_all();          return false;
+    case MenuCommandAssignUp:       assign_shortcut(ShortcutUp);       return false;
+    case MenuCommandAssignUpLong:   assign_shortcut(ShortcutUpLong);   return false;
+    case MenuCommandAssignDown:     assign_shortcut(ShortcutDown);     return false;
+    case MenuCommandAssignDownLong: assign_shortcut(ShortcutDownLong); return false;
+    case MenuCommandDumpTrace:      dump_trace();                      return true;
+    default:                        return compose_command(command);
+  }
+}
+
+static void menu_closed_handler() {
+  // Every level along the path has been released by now
+  HEAP_DEBUG_SAMPLE("close");
+  BENCHMARK_MENU_DID_CLOSE();
+}
+
+static bool open_action_menu() {
+#if BATTERY_SAVER
+  // The charge may have changed since the menu was last shown
+  update_vibration_costs();
+#endif
+  if(!menu_open()) {
+    return false;
+  }
+  TRACE_EVENT(TraceEventMenuOpen);
+  HEAP_DEBUG_SAMPLE("open");
+  return true;
+}
+
+static void close_action_menu() {
+  menu_close(true);
 }
 
 /*********************************** Clicks ***********************************/
 
 static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
-  // Configure the ActionMenu Window about to be shown
-  ActionMenuConfig config = (ActionMenuConfig) {
-    .root_level = s_root_level,
-    .colors = {
-      .background = PBL_IF_COLOR_ELSE(GColorChromeYellow, GColorWhite),
-      .foreground = GColorBlack,
-    },
-    .align = ActionMenuAlignCenter
-  };
+  TRACE_EVENT(TraceEventClick);
+  open_action_menu();
+}
+
+static void select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
+  // Replay the last vibration without going through the menu
+  TRACE_EVENT(TraceEventClick);
+  if(s_current_type < VibrationTypeCount) {
+    play_vibration(s_current_type);
+  } else {
+    open_action_menu();
+  }
+}
 
-  // Show the ActionMenu
-  s_action_menu = action_menu_open(&config);
+static void fire_shortcut(Shortcut shortcut) {
+  // Plays straight away, no ActionMenu is built for it
+  TRACE_EVENT(TraceEventClick);
+  const VibrationType type = shortcuts_get(shortcut);
+  if(type < VibrationTypeCount) {
+    choose_vibration(type);
+  }
+}
+
+static void shortcut_click_handler(ClickRecognizerRef recognizer, void *context) {
+  const bool is_up = (click_recognizer_get_button_id(recognizer) == BUTTON_ID_UP);
+  fire_shortcut(is_up ? ShortcutUp : ShortcutDown);
+}
+
+static void shortcut_long_click_handler(ClickRecognizerRef recognizer, void *context) {
+  const bool is_up = (click_recognizer_get_button_id(recognizer) == BUTTON_ID_UP);
+  fire_shortcut(is_up ? ShortcutUpLong : ShortcutDownLong);
 }
 
 static void click_config_provider(void *context) {
   window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
+  window_long_click_subscribe(BUTTON_ID_SELECT, 0, select_long_click_handler, NULL);
+  window_single_click_subscribe(BUTTON_ID_UP, shortcut_click_handler);
+  window_long_click_subscribe(BUTTON_ID_UP, 0, shortcut_long_click_handler, NULL);
+  window_single_click_subscribe(BUTTON_ID_DOWN, shortcut_click_handler);
+  window_long_click_subscribe(BUTTON_ID_DOWN, 0, shortcut_long_click_handler, NULL);
 }
 
 /******************************** Main Window *********************************/
@@ -114,37 +349,76 @@ static void window_load(Window *window) {
   Layer *window_layer = window_get_root_layer(window);
   GRect bounds = layer_get_bounds(window_layer);
 
-  s_ellipsis_bitmap = gbitmap_create_with_resource(RESOURCE_ID_ELLIPSIS);
-
   s_action_bar = action_bar_layer_create();
   action_bar_layer_set_click_config_provider(s_action_bar, click_config_provider);
-  action_bar_layer_set_icon(s_action_bar, BUTTON_ID_SELECT, s_ellipsis_bitmap);
+  action_bar_layer_set_icon(s_action_bar, BUTTON_ID_SELECT, icon_atlas_get(IconEllipsis));
   action_bar_layer_add_to_window(s_action_bar, window);
 
-  s_label_layer = text_layer_create(GRect(bounds.origin.x, bounds.origin.y, bounds.size.w - ACTION_BAR_WIDTH, bounds.size.h));
-  text_layer_set_text(s_label_layer, "Choose a vibration pattern from the Action Menu.");
-  text_layer_set_font(s_label_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-  text_layer_set_text_color(s_label_layer, GColorBlack);
-  text_layer_set_background_color(s_label_layer, GColorClear);
-  text_layer_set_text_alignment(s_label_layer, GTextAlignmentCenter);
-  layer_add_child(window_layer, text_layer_get_layer(s_label_layer));
+  const int16_t content_width = bounds.size.w - ACTION_BAR_WIDTH;
+  const int16_t status_y = bounds.size.h - STATUS_MARGIN - STATUS_HEIGHT;
 
-#if defined(PBL_ROUND)
-  text_layer_enable_screen_text_flow_and_paging(s_label_layer, 3);
-#endif
+  // Laid out once here, so returning from the menu only redraws the lines
+  s_label_layer = label_layer_create(GRect(bounds.origin.x, bounds.origin.y, content_width, status_y),
+                                     bounds, "Choose a vibration pattern from the Action Menu.",
+                                     fonts_get_system_font(s_memory_tier == MemoryTierLow ?
+                                                           FONT_KEY_GOTHIC_18_BOLD : FONT_KEY_GOTHIC_24_BOLD));
+  layer_add_child(window_layer, s_label_layer);
+
+  // Inset like the label's lines, so the circle doesn't cut it off on round displays
+  const GRect status_frame = GRect(bounds.origin.x, status_y, content_width, STATUS_HEIGHT);
+  s_status_layer = status_layer_create(label_layer_get_line_box(status_frame, bounds));
+  status_layer_set_type(s_status_layer, s_current_type);
+  layer_add_child(window_layer, s_status_layer);
+
+  HEAP_DEBUG_ATTACH(s_label_layer);
 }
 
 static void window_unload(Window *window) {
-  text_layer_destroy(s_label_layer);
-  action_bar_layer_destroy(s_action_bar);
-  gbitmap_destroy(s_ellipsis_bitmap);
+  // A menu must not outlive the Window it was opened from
+  menu_close(false);
 
-  action_menu_hierarchy_destroy(s_root_level, NULL, NULL);
+  HEAP_DEBUG_SAMPLE("unload");
+  HEAP_DEBUG_DETACH();
+  status_layer_destroy(s_status_layer);
+  label_layer_destroy(s_label_layer);
+  action_bar_layer_destroy(s_action_bar);
 }
 
 /************************************ App *************************************/
 
+static void worker_launch_timer_callback(void *context) {
+  // Stay until every job due together has played
+  if(vibe_worker_is_playing()) {
+    app_timer_register(WORKER_LAUNCH_LINGER_MS, worker_launch_timer_callback, NULL);
+  } else {
+    window_stack_pop_all(false);
+  }
+}
+
 static void init() {
+  // Measured before anything of ours is allocated
+  const size_t free_bytes = heap_bytes_free();
+  s_memory_tier = (free_bytes < MEMORY_LOW_TIER_FREE_BYTES) ? MemoryTierLow : MemoryTierFull;
+  if(s_memory_tier == MemoryTierLow) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "Low memory tier, %u bytes free", (unsigned)free_bytes);
+  }
+
+  if(persist_exists(PersistKeyLastType)) {
+    const int32_t type = persist_read_int(PersistKeyLastType);
+    if(type >= 0 && type < VibrationTypeCount) {
+      s_current_type = type;
+    }
+  }
+  s_saved_type = s_current_type;
+  persist_read_data(PersistKeyUsageCounts, s_usage_counts, sizeof(s_usage_counts));
+  shortcuts_init();
+
+  // Icons outlive the Window, so reloading it doesn't read them again. The
+  // action bar still works without them.
+  if(s_memory_tier == MemoryTierFull) {
+    icon_atlas_init();
+  }
+
   s_main_window = window_create();
   window_set_background_color(s_main_window, PBL_IF_COLOR_ELSE(GColorChromeYellow, GColorWhite));
   window_set_window_handlers(s_main_window, (WindowHandlers) {
@@ -153,14 +427,39 @@ static void init() {
   });
   window_stack_push(s_main_window, true);
 
-  init_action_menu();
+  menu_set_ranking(&s_current_type, s_usage_counts);
+  menu_set_flatten(s_memory_tier == MemoryTierLow);
+#if BATTERY_SAVER
+  menu_set_costs(s_vibration_costs);
+#endif
+  menu_init(choose_vibration, menu_command_handler, menu_closed_handler);
+  HEAP_DEBUG_SAMPLE("init");
+
+  if(vibe_worker_init(play_worker_vibration)) {
+    app_timer_register(WORKER_LAUNCH_LINGER_MS, worker_launch_timer_callback, NULL);
+  }
+
+  BENCHMARK_START(open_action_menu, close_action_menu);
+  STRESS_LIFECYCLE_START(s_main_window, open_action_menu, close_action_menu);
+  MENU_FUZZ_START(s_memory_tier == MemoryTierLow);
 }
 
 static void deinit() {
+  if(s_save_timer) {
+    app_timer_cancel(s_save_timer);
+  }
+  save_choices();
+  vibe_worker_deinit();
   window_destroy(s_main_window);
+
+  menu_deinit();
+  icon_atlas_deinit();
+  PROFILE_REPORT();
+  TRACE_DUMP();
 }
 
 int main() {
+  HEAP_DEBUG_INIT();
   init();
   app_event_loop();
   deinit();
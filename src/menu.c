@@ -0,0 +1,427 @@
+/**
+ * menu.c - Builds ActionMenus from the packed menu definition. Every
+ * ActionMenu on screen is a frame rooted at one definition level. A narrow
+ * child level without children is materialised inline as a native child
+ * level, while any other becomes an action that opens a new frame over the
+ * current one. Closing a frame releases its
+ * levels, so memory follows the path being viewed rather than the tree.
+ */
+
+#include "menu.h"
+
+#include "arena.h"
+#include "config.h"
+#include "menu_build.h"
+#include "menu_cache.h"
+#include "menu_data.h"
+#include "menu_fuzz.h"
+#include "menu_sync.h"
+#include "profiler.h"
+#include "trace.h"
+
+// Action data carries the item kind in the high byte and its value in the low
+#define MENU_ACTION_DATA(kind, value) ((void *)(uintptr_t)(((kind) << 8) | (value)))
+#define MENU_ACTION_KIND(data) ((uint8_t)((uintptr_t)(data) >> 8))
+#define MENU_ACTION_VALUE(data) ((uint8_t)(uintptr_t)(data))
+
+// One ActionMenu on the current path, with the levels built for it
+typedef struct {
+  ActionMenu *menu;
+  ActionMenuLevel *root;
+  Arena arena;
+} MenuFrame;
+
+static MenuActionHandler s_action_handler;
+static MenuCommandHandler s_command_handler;
+static MenuClosedHandler s_closed_handler;
+static ActionMenuConfig s_config;
+
+static MenuBuild s_build;
+
+static uint8_t *s_data;
+static size_t s_data_size;
+
+// Definition received while the menu was open, adopted once it closes
+static uint8_t *s_pending_data;
+static size_t s_pending_data_size;
+
+static MenuFrame s_frames[MENU_MAX_DEPTH + 1];
+static int s_depth;
+
+// Set once an action is chosen, so each frame closing closes its parent too
+static bool s_unwinding;
+
+// Frozen to keep it open after a command, until the next turn of the event loop
+static ActionMenu *s_held_menu;
+
+#if MENU_COMMIT == MENU_COMMIT_AFTER_CLOSE
+// Chosen action waiting for the whole path to finish closing
+static VibrationType s_committed_type = VibrationTypeCount;
+#elif MENU_COMMIT == MENU_COMMIT_UNANIMATED
+// Frozen after an action, closed without animation on the next turn of the event loop
+static ActionMenu *s_closing_menu;
+#endif
+
+static bool open_frame(int level_index);
+
+/********************************* Definition *********************************/
+
+static bool is_usable_data(const uint8_t *data, size_t size) {
+  // Checked whole on arrival, so a bad tree can't break every open from then on
+  return menu_data_validate(data, size, VibrationTypeCount, MenuCommandCount, MENU_MAX_DEPTH);
+}
+
+static void set_data(uint8_t *data, size_t size) {
+  free(s_data);
+  s_data = data;
+  s_data_size = size;
+  s_build.data = s_data;
+  s_build.size = s_data_size;
+  menu_sync_set_current(s_data, s_data_size);
+}
+
+static void apply_pending_data() {
+  if(s_pending_data) {
+    set_data(s_pending_data, s_pending_data_size);
+    s_pending_data = NULL;
+    s_pending_data_size = 0;
+  }
+}
+
+static void menu_sync_updated_handler(uint8_t *data, size_t size) {
+  // Such as from a phone that knows types or commands this version doesn't
+  if(!is_usable_data(data, size)) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Ignoring unusable menu definition from the phone");
+    free(data);
+    return;
+  }
+  menu_cache_store(data, size);
+
+  // Labels of an open menu point into the current data, so swap once it closes
+  free(s_pending_data);
+  s_pending_data = data;
+  s_pending_data_size = size;
+  if(s_depth == 0) {
+    apply_pending_data();
+  } else {
+    menu_sync_set_current(s_pending_data, s_pending_data_size);
+  }
+}
+
+static void load_data() {
+  // Prefer the last definition from the phone, the phone sends any changes later
+  uint8_t *cached_data;
+  size_t cached_size;
+  if(menu_cache_load(&cached_data, &cached_size)) {
+    if(is_usable_data(cached_data, cached_size)) {
+      set_data(cached_data, cached_size);
+      return;
+    }
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Dropping unusable cached menu definition");
+    free(cached_data);
+    menu_cache_store(NULL, 0);
+  }
+
+  // Keep the packed definition resident, the levels point into it for labels
+  ResHandle handle = resource_get_handle(RESOURCE_ID_MENU);
+  const size_t size = resource_size(handle);
+  uint8_t *data = malloc(size);
+  if(data) {
+    resource_load(handle, data, size);
+    set_data(data, size);
+  }
+}
+
+/*********************************** Frames ***********************************/
+
+static void release_held_menu(void *context) {
+  if(s_held_menu && s_depth > 0 && s_frames[s_depth - 1].menu == s_held_menu) {
+    action_menu_unfreeze(s_held_menu);
+  }
+  s_held_menu = NULL;
+}
+
+#if MENU_COMMIT == MENU_COMMIT_UNANIMATED
+static void close_unanimated(void *context) {
+  if(s_closing_menu && s_depth > 0 && s_frames[s_depth - 1].menu == s_closing_menu) {
+    action_menu_close(s_closing_menu, false);
+  }
+  s_closing_menu = NULL;
+}
+#endif
+
+static void action_performed_callback(ActionMenu *action_menu, const ActionMenuItem *action, void *context) {
+  TRACE_EVENT(TraceEventAction);
+  void *data = action_menu_item_get_action_data(action);
+  switch(MENU_ACTION_KIND(data)) {
+    case MenuItemKindChild:
+      // Hold this menu in place while the level below opens over it
+      action_menu_freeze(action_menu);
+      if(!open_frame(MENU_ACTION_VALUE(data))) {
+        action_menu_unfreeze(action_menu);
+      }
+      return;
+    case MenuItemKindCommand:
+      // Being frozen when this returns keeps the menu open, it is released
+      // again once the ActionMenu has moved on
+      if(s_command_handler((MenuCommand)MENU_ACTION_VALUE(data))) {
+        action_menu_freeze(action_menu);
+        s_held_menu = action_menu;
+        app_timer_register(0, release_held_menu, NULL);
+        return;
+      }
+      break;
+    default:
+#if MENU_COMMIT == MENU_COMMIT_AFTER_CLOSE
+      // Played from did_close, so the vibe doesn't compete with the animation
+      s_committed_type = (VibrationType)MENU_ACTION_VALUE(data);
+#else
+      s_action_handler((VibrationType)MENU_ACTION_VALUE(data));
+#endif
+#if MENU_COMMIT == MENU_COMMIT_UNANIMATED
+      // Being frozen stops the animated close, this one replaces it
+      action_menu_freeze(action_menu);
+      s_closing_menu = action_menu;
+      app_timer_register(0, close_unanimated, NULL);
+#endif
+      break;
+  }
+  s_unwinding = true;
+}
+
+/********************************** Builder ***********************************/
+
+static void *create_level(int capacity) {
+  return action_menu_level_create(capacity);
+}
+
+static bool add_action(void *level, const char *label, uint8_t kind, uint8_t value) {
+  // Actions, and deeper levels which are only built once chosen
+  return action_menu_level_add_action(level, label, action_performed_callback,
+                                      MENU_ACTION_DATA(kind, value)) != NULL;
+}
+
+static bool add_child(void *level, void *child, const char *label) {
+  return action_menu_level_add_child(level, child, label) != NULL;
+}
+
+static void destroy_level(void *level) {
+  action_menu_hierarchy_destroy(level, NULL, NULL);
+}
+
+static const MenuBuilder s_builder = {
+  .create_level = create_level,
+  .add_action = add_action,
+  .add_child = add_child,
+  .destroy_level = destroy_level,
+  .level_built = MENU_FUZZ_LEVEL_BUILT_HANDLER,
+};
+
+static void destroy_frame(MenuFrame *frame) {
+  if(frame->root) {
+    action_menu_hierarchy_destroy(frame->root, NULL, NULL);
+  }
+  arena_release(&frame->arena);
+  *frame = (MenuFrame) { 0 };
+}
+
+static bool build_frame(MenuFrame *frame, int level_index, int depth) {
+  // Size the arena up front, so building the levels makes no other
+  // allocations of our own between the firmware's
+  const size_t arena_size = menu_build_frame_arena_size(&s_build, level_index);
+  if(arena_size == 0 || !arena_init(&frame->arena, arena_size)) {
+    return false;
+  }
+
+  frame->root = menu_build_level(&s_build, &frame->arena, level_index, depth, true);
+  if(!frame->root) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Couldn't build menu level %d", level_index);
+    destroy_frame(frame);
+    return false;
+  }
+  return true;
+}
+
+static bool open_frame(int level_index) {
+  if(s_depth > MENU_MAX_DEPTH) {
+    return false;
+  }
+
+  MenuFrame *frame = &s_frames[s_depth];
+  if(!build_frame(frame, level_index, s_depth)) {
+    return false;
+  }
+
+  s_config.root_level = frame->root;
+  PROFILE_MENU_OPEN();
+  frame->menu = action_menu_open(&s_config);
+  s_config.root_level = NULL;
+  if(!frame->menu) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Couldn't open the menu for level %d", level_index);
+    destroy_frame(frame);
+    return false;
+  }
+  s_depth++;
+  return true;
+}
+
+static void action_menu_did_close(ActionMenu *action_menu, const ActionMenuItem *performed_action, void *context) {
+  if(s_depth == 0) {
+    return;
+  }
+
+  PROFILE_MENU_DID_CLOSE();
+
+  // Frames close top down, the levels are only needed while on screen
+  if(s_held_menu == action_menu) {
+    s_held_menu = NULL;
+  }
+#if MENU_COMMIT == MENU_COMMIT_UNANIMATED
+  if(s_closing_menu == action_menu) {
+    s_closing_menu = NULL;
+  }
+#endif
+  destroy_frame(&s_frames[--s_depth]);
+
+  if(s_depth > 0) {
+    // Choosing an action closes the whole path, backing out only this frame
+    ActionMenu *parent = s_frames[s_depth - 1].menu;
+    if(s_unwinding) {
+      action_menu_close(parent, false);
+    } else {
+      action_menu_unfreeze(parent);
+    }
+    return;
+  }
+
+  s_unwinding = false;
+  apply_pending_data();
+#if MENU_COMMIT == MENU_COMMIT_AFTER_CLOSE
+  if(s_committed_type < VibrationTypeCount) {
+    const VibrationType type = s_committed_type;
+    s_committed_type = VibrationTypeCount;
+    s_action_handler(type);
+  }
+#endif
+  s_closed_handler();
+}
+
+/************************************ API *************************************/
+
+void menu_init(MenuActionHandler action_handler, MenuCommandHandler command_handler,
+               MenuClosedHandler closed_handler) {
+  s_action_handler = action_handler;
+  s_command_handler = command_handler;
+  s_closed_handler = closed_handler;
+  s_build.builder = &s_builder;
+
+  // Configure the ActionMenu Window once, only the root level changes per open
+  s_config = (ActionMenuConfig) {
+    .colors = {
+      .background = PBL_IF_COLOR_ELSE(GColorChromeYellow, GColorWhite),
+      .foreground = GColorBlack,
+    },
+    .did_close = action_menu_did_close,
+    .align = ActionMenuAlignCenter
+  };
+
+  menu_sync_init(menu_sync_updated_handler);
+  load_data();
+}
+
+void menu_deinit() {
+  // Normally done by did_close, unless the app exited with the menu still open
+  while(s_depth > 0) {
+    destroy_frame(&s_frames[--s_depth]);
+  }
+
+  menu_sync_deinit();
+  free(s_pending_data);
+  free(s_data);
+  s_pending_data = NULL;
+  s_data = NULL;
+}
+
+void menu_set_ranking(const VibrationType *last_used, const uint16_t *usage_counts) {
+  s_build.last_used = last_used;
+  s_build.usage_counts = usage_counts;
+}
+
+void menu_set_costs(const uint16_t *cost_ms) {
+  s_build.costs = cost_ms;
+}
+
+void menu_set_flatten(bool flatten) {
+  s_build.flatten = flatten;
+}
+
+#if FUZZ_MENU
+void menu_set_definition(uint8_t *data, size_t size) {
+  if(s_depth > 0) {
+    free(data);
+    return;
+  }
+  if(data) {
+    set_data(data, size);
+  } else {
+    load_data();
+  }
+}
+#endif
+
+#if FUZZ_MENU
+static bool build_frames_from(int level_index, int depth) {
+  // Each frame stays built while those opened over it are, as on screen
+  if(depth > MENU_MAX_DEPTH || !build_frame(&s_frames[depth], level_index, depth)) {
+    return false;
+  }
+
+  size_t length;
+  const uint8_t *record = menu_data_find_record(s_data, s_data_size, level_index, &length);
+  const uint8_t *cursor = record + 1;
+  bool valid = true;
+  for(int i = 0; valid && i < record[0]; i++) {
+    MenuItem item;
+    valid = menu_build_read_item(&cursor, record + length, &item);
+    if(valid && item.kind == MenuItemKindChild && !menu_build_is_inline_child(&s_build, &item, true)) {
+      valid = build_frames_from(item.value, depth + 1);
+    }
+  }
+  destroy_frame(&s_frames[depth]);
+  return valid;
+}
+
+bool menu_build_every_frame() {
+  const int num_levels = menu_data_num_levels(s_data, s_data_size);
+  if(s_depth > 0 || num_levels == 0) {
+    return false;
+  }
+  return build_frames_from(num_levels - 1, 0);
+}
+#endif
+
+bool menu_open() {
+  // Coalesce repeated presses until the current menu has closed
+  if(s_depth > 0) {
+    return false;
+  }
+
+  // The root is the last record
+  const int num_levels = menu_data_num_levels(s_data, s_data_size);
+  if(num_levels == 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Unsupported menu definition");
+    return false;
+  }
+  return open_frame(num_levels - 1);
+}
+
+void menu_close(bool animated) {
+  if(s_depth > 0) {
+    s_unwinding = true;
+    action_menu_close(s_frames[s_depth - 1].menu, animated);
+  }
+}
+
+bool menu_is_open() {
+  return s_depth > 0;
+}
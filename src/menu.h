@@ -0,0 +1,54 @@
+#pragma once
+
+/**
+ * menu.h - Owns the menu definition and the ActionMenus shown from it. Only
+ * the ActionMenus along the path currently on screen are materialised: each
+ * level with further levels beneath it, or too wide to show inline, opens as
+ * its own ActionMenu on top of its parent. A narrow child level without
+ * children of its own is shown inline.
+ */
+
+#include <pebble.h>
+
+#include "config.h"
+#include "menu_commands.h"
+#include "vibration_types.h"
+
+typedef void (*MenuActionHandler)(VibrationType type);
+typedef void (*MenuClosedHandler)(void);
+
+// Return true to keep the menu open on the same level after the command
+typedef bool (*MenuCommandHandler)(MenuCommand command);
+
+// Load the definition and start listening for updates from the phone
+void menu_init(MenuActionHandler action_handler, MenuCommandHandler command_handler,
+               MenuClosedHandler closed_handler);
+void menu_deinit(void);
+
+// Items are ordered by these, both are read each time a level is built
+void menu_set_ranking(const VibrationType *last_used, const uint16_t *usage_counts);
+
+// Label actions with their cost in ms of motor time, read each time a level is built
+void menu_set_costs(const uint16_t *cost_ms);
+
+// Splice child levels of actions into the level above instead of nesting them
+void menu_set_flatten(bool flatten);
+
+#if FUZZ_MENU
+// Adopt data as the definition while the menu is closed, NULL reloads the
+// stored one. Ownership passes to the menu either way.
+void menu_set_definition(uint8_t *data, size_t size);
+
+// Build and release every frame the definition can open while the menu is
+// closed, each over its parent as if its portal had been chosen. Returns false
+// if any of them failed to build.
+bool menu_build_every_frame(void);
+#endif
+
+// Open the root level, returning false if already open or it can't be built
+bool menu_open(void);
+
+// Close every ActionMenu along the current path
+void menu_close(bool animated);
+
+bool menu_is_open(void);
@@ -0,0 +1,298 @@
+/**
+ * menu_build.c - Orders and sizes the levels of a frame, then builds them
+ * through the caller's MenuBuilder
+ */
+
+#include "menu_build.h"
+
+#include <stdio.h>
+
+#include "menu_commands.h"
+#include "menu_data.h"
+
+#define MENU_COMMAND_LABEL(name, label) [MenuCommand##name] = label,
+
+// Used for commands the menu definition leaves unlabelled
+static const char *const s_command_labels[MenuCommandCount] = {
+  MENU_COMMANDS(MENU_COMMAND_LABEL)
+};
+
+/*********************************** Items ************************************/
+
+bool menu_build_read_item(const uint8_t **cursor, const uint8_t *end, MenuItem *item) {
+  if(end - *cursor < MENU_ITEM_HEADER_SIZE) {
+    return false;
+  }
+
+  // Labels are used straight out of the resource buffer, so must be terminated.
+  // Actions may leave theirs empty to use the type's default label.
+  const uint8_t label_length = (*cursor)[2];
+  *item = (MenuItem) {
+    .kind = (*cursor)[0],
+    .value = (*cursor)[1],
+    .label = label_length ? (const char *)&(*cursor)[MENU_ITEM_HEADER_SIZE] : NULL,
+  };
+  *cursor += MENU_ITEM_HEADER_SIZE + label_length;
+  return *cursor <= end && (label_length == 0 || item->label[label_length - 1] == '\0');
+}
+
+static bool rank_level(const MenuBuild *build, int level_index, int depth, MenuRank *rank);
+
+static bool rank_menu_item(const MenuBuild *build, int level_index, int depth, MenuItem *item) {
+  switch(item->kind) {
+    case MenuItemKindAction:
+      if(item->value >= VibrationTypeCount) {
+        return false;
+      }
+      if(!item->label) {
+        item->label = vibration_type_get_label(item->value);
+      }
+      item->rank = (MenuRank) {
+        .has_last_used = build->last_used && (item->value == *build->last_used),
+        .uses = build->usage_counts ? build->usage_counts[item->value] : 0,
+      };
+      return true;
+    case MenuItemKindChild:
+      // Children always precede their parent, which also rules out cycles
+      if(item->value >= level_index || !item->label) {
+        return false;
+      }
+      item->rank = (MenuRank) { 0 };
+      return rank_level(build, item->value, depth + 1, &item->rank);
+    case MenuItemKindCommand:
+      if(item->value >= MenuCommandCount) {
+        return false;
+      }
+      if(!item->label) {
+        item->label = s_command_labels[item->value];
+      }
+      item->rank = (MenuRank) { 0 };
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool rank_level(const MenuBuild *build, int level_index, int depth, MenuRank *rank) {
+  // A level's rank is that of everything beneath it, built or not
+  size_t length;
+  const uint8_t *record = menu_data_find_record(build->data, build->size, level_index, &length);
+  if(!record || depth > MENU_MAX_DEPTH) {
+    return false;
+  }
+
+  const uint8_t *cursor = record + 1;
+  for(int i = 0; i < record[0]; i++) {
+    MenuItem item;
+    if(!menu_build_read_item(&cursor, record + length, &item) ||
+       !rank_menu_item(build, level_index, depth, &item)) {
+      return false;
+    }
+    rank->has_last_used |= item.rank.has_last_used;
+    rank->uses += item.rank.uses;
+  }
+  return true;
+}
+
+static bool menu_rank_precedes(const MenuRank *a, const MenuRank *b) {
+  // The last used action and the path to it come first, then the most used
+  if(a->has_last_used != b->has_last_used) {
+    return a->has_last_used;
+  }
+  return a->uses > b->uses;
+}
+
+static void sort_menu_items(MenuItem *items, int num_items) {
+  // Stable, so equally ranked items keep the order of the definition
+  for(int i = 1; i < num_items; i++) {
+    const MenuItem item = items[i];
+    int j = i - 1;
+    for(; j >= 0 && menu_rank_precedes(&item.rank, &items[j].rank); j--) {
+      items[j + 1] = items[j];
+    }
+    items[j + 1] = item;
+  }
+}
+
+static bool is_leaf_level(const MenuBuild *build, int level_index, bool actions_only) {
+  size_t length;
+  const uint8_t *record = menu_data_find_record(build->data, build->size, level_index, &length);
+  if(!record) {
+    return false;
+  }
+
+  const uint8_t *cursor = record + 1;
+  for(int i = 0; i < record[0]; i++) {
+    MenuItem item;
+    if(!menu_build_read_item(&cursor, record + length, &item) || item.kind == MenuItemKindChild ||
+       (actions_only && item.kind != MenuItemKindAction)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*********************************** Sizing ***********************************/
+
+static int get_level_size(const MenuBuild *build, int level_index) {
+  size_t length;
+  const uint8_t *record = menu_data_find_record(build->data, build->size, level_index, &length);
+  return record ? record[0] : 0;
+}
+
+bool menu_build_is_inline_child(const MenuBuild *build, const MenuItem *item, bool is_frame_root) {
+  // A narrow level without children only costs its own items, so show it
+  // within the frame. Anything else would grow the frame with the tree.
+  return item->kind == MenuItemKindChild && is_frame_root &&
+         get_level_size(build, item->value) <= MENU_INLINE_MAX_WIDTH &&
+         is_leaf_level(build, item->value, false);
+}
+
+static bool is_flattened_child(const MenuBuild *build, const MenuItem *item, bool is_frame_root) {
+  // Only vibrations read on their own, commands need the level's label
+  return build->flatten && menu_build_is_inline_child(build, item, is_frame_root) &&
+         is_leaf_level(build, item->value, true);
+}
+
+static int get_level_capacity(const MenuBuild *build, const MenuItem *items, int num_items,
+                              bool is_frame_root) {
+  // A flattened child's items take its own place
+  int capacity = num_items;
+  for(int i = 0; i < num_items; i++) {
+    if(is_flattened_child(build, &items[i], is_frame_root)) {
+      capacity += get_level_size(build, items[i].value) - 1;
+    }
+  }
+  return capacity;
+}
+
+static size_t level_scratch_size(const MenuBuild *build, const uint8_t *record) {
+  const size_t item_size = sizeof(MenuItem) + (build->costs ? MENU_COST_LABEL_SIZE : 0);
+  return record[0] * item_size + sizeof(uintptr_t);
+}
+
+size_t menu_build_frame_arena_size(const MenuBuild *build, int level_index) {
+  // Item scratch for the level and every child level shown inline within it
+  size_t length;
+  const uint8_t *record = menu_data_find_record(build->data, build->size, level_index, &length);
+  if(!record) {
+    return 0;
+  }
+
+  size_t size = level_scratch_size(build, record);
+  const uint8_t *cursor = record + 1;
+  for(int i = 0; i < record[0]; i++) {
+    // Portals are only read once chosen, into the arena of their own frame
+    MenuItem item;
+    size_t child_length;
+    const uint8_t *child;
+    if(menu_build_read_item(&cursor, record + length, &item) &&
+       menu_build_is_inline_child(build, &item, true) &&
+       (child = menu_data_find_record(build->data, build->size, item.value, &child_length))) {
+      size += level_scratch_size(build, child);
+    }
+  }
+  return size;
+}
+
+/*********************************** Levels ***********************************/
+
+static const char *get_item_label(const MenuBuild *build, Arena *arena, const MenuItem *item) {
+  if(!build->costs || item->kind != MenuItemKindAction) {
+    return item->label;
+  }
+
+  // Lives in the frame's arena, as long as the level showing it
+  char *label = arena_alloc(arena, MENU_COST_LABEL_SIZE);
+  if(!label) {
+    return item->label;
+  }
+  snprintf(label, MENU_COST_LABEL_SIZE, "%s (%ums)", item->label, build->costs[item->value]);
+  return label;
+}
+
+static int read_level_items(const MenuBuild *build, Arena *arena, int level_index, int depth,
+                            MenuItem **items) {
+  size_t length;
+  const uint8_t *record = menu_data_find_record(build->data, build->size, level_index, &length);
+  if(!record) {
+    return -1;
+  }
+
+  // Read the whole record first so the items can be ordered by usage
+  const uint8_t num_items = record[0];
+  *items = arena_alloc(arena, num_items * sizeof(MenuItem));
+  if(!*items) {
+    return -1;
+  }
+  const uint8_t *cursor = record + 1;
+  for(int i = 0; i < num_items; i++) {
+    if(!menu_build_read_item(&cursor, record + length, &(*items)[i]) ||
+       !rank_menu_item(build, level_index, depth, &(*items)[i])) {
+      return -1;
+    }
+  }
+  sort_menu_items(*items, num_items);
+  return num_items;
+}
+
+static bool add_action(const MenuBuild *build, Arena *arena, void *level, const MenuItem *item) {
+  // Actions, and deeper levels which are only built once chosen
+  return build->builder->add_action(level, get_item_label(build, arena, item), item->kind, item->value);
+}
+
+static bool add_flattened_level(const MenuBuild *build, Arena *arena, void *level, int level_index, int depth,
+                                int *num_added) {
+  // The child's items take its place in the parent, saving a level
+  MenuItem *items;
+  const int num_items = read_level_items(build, arena, level_index, depth, &items);
+  for(int i = 0; i < num_items; i++) {
+    if(!add_action(build, arena, level, &items[i])) {
+      return false;
+    }
+    (*num_added)++;
+  }
+  return num_items >= 0;
+}
+
+void *menu_build_level(const MenuBuild *build, Arena *arena, int level_index, int depth, bool is_frame_root) {
+  const MenuBuilder *builder = build->builder;
+  MenuItem *items;
+  const int num_items = read_level_items(build, arena, level_index, depth, &items);
+  if(num_items < 0) {
+    return NULL;
+  }
+
+  const int capacity = get_level_capacity(build, items, num_items, is_frame_root);
+  void *level = builder->create_level(capacity);
+  if(!level) {
+    return NULL;
+  }
+  bool valid = true;
+  int num_added = 0;
+  for(int i = 0; valid && i < num_items; i++) {
+    const MenuItem *item = &items[i];
+    if(is_flattened_child(build, item, is_frame_root)) {
+      valid = add_flattened_level(build, arena, level, item->value, depth + 1, &num_added);
+    } else if(!menu_build_is_inline_child(build, item, is_frame_root)) {
+      valid = add_action(build, arena, level, item);
+      num_added += valid;
+    } else {
+      void *child = menu_build_level(build, arena, item->value, depth + 1, false);
+      valid = child && builder->add_child(level, child, item->label);
+      num_added += valid;
+      if(child && !valid) {
+        builder->destroy_level(child);
+      }
+    }
+  }
+  if(builder->level_built) {
+    builder->level_built(capacity, num_added, valid);
+  }
+
+  if(!valid) {
+    builder->destroy_level(level);
+    return NULL;
+  }
+  return level;
+}
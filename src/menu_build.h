@@ -0,0 +1,73 @@
+#pragma once
+
+/**
+ * menu_build.h - Builds the levels of one ActionMenu frame from the packed
+ * menu definition: reading, ranking and ordering items, choosing which child
+ * levels are shown inline or flattened, and sizing each level and the
+ * frame's arena. Free of pebble.h, the firmware calls that create and fill
+ * the levels are made through a MenuBuilder.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "vibration_types.h"
+
+// Room for an action's label with its cost appended, longer labels are cut short
+#define MENU_COST_LABEL_SIZE 32
+
+// Widest child level shown inline, wider ones open as a frame of their own.
+// A frame holds at most this many items for each item of its root level.
+#define MENU_INLINE_MAX_WIDTH 8
+
+// How strongly an item or a level's subtree should be promoted in its level
+typedef struct {
+  bool has_last_used;
+  uint32_t uses;
+} MenuRank;
+
+typedef struct {
+  uint8_t kind;
+  uint8_t value;
+  const char *label;
+  MenuRank rank;
+} MenuItem;
+
+// Creates and fills the caller's levels, each passed back as an opaque pointer
+typedef struct {
+  void *(*create_level)(int capacity);
+  bool (*add_action)(void *level, const char *label, uint8_t kind, uint8_t value);
+  bool (*add_child)(void *level, void *child, const char *label);
+  void (*destroy_level)(void *level);
+
+  // Called once per level built, valid is false if it was abandoned
+  void (*level_built)(int capacity, int num_added, bool valid);
+} MenuBuilder;
+
+// The definition and settings levels are built from, all are read each build
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+  const VibrationType *last_used;
+  const uint16_t *usage_counts;
+  const uint16_t *costs;
+  bool flatten;
+  const MenuBuilder *builder;
+} MenuBuild;
+
+// Read the item at cursor and advance past it, false if it overruns end
+bool menu_build_read_item(const uint8_t **cursor, const uint8_t *end, MenuItem *item);
+
+// Whether a child item of the frame's root level is shown within the frame,
+// rather than as a portal that opens a frame of its own. Only levels of no
+// more than MENU_INLINE_MAX_WIDTH items without children of their own are.
+bool menu_build_is_inline_child(const MenuBuild *build, const MenuItem *item, bool is_frame_root);
+
+// Bytes of arena a frame rooted at level_index needs, 0 if it doesn't exist
+size_t menu_build_frame_arena_size(const MenuBuild *build, int level_index);
+
+// Build level_index and any children shown inline, carving item scratch and
+// labels out of arena. Returns the level, or NULL with nothing left created.
+void *menu_build_level(const MenuBuild *build, Arena *arena, int level_index, int depth, bool is_frame_root);
@@ -0,0 +1,82 @@
+/**
+ * menu_cache.c - Stores the definition split over consecutive keys, as each
+ * key holds at most PERSIST_DATA_MAX_LENGTH bytes. The size and hash are
+ * written last and checked on load, so an interrupted store is never used.
+ */
+
+#include "menu_cache.h"
+
+#include "menu_data.h"
+#include "persist_keys.h"
+
+#define MAX_SIZE (MENU_CACHE_MAX_CHUNKS * PERSIST_DATA_MAX_LENGTH)
+
+static int num_chunks(size_t size) {
+  return (size + PERSIST_DATA_MAX_LENGTH - 1) / PERSIST_DATA_MAX_LENGTH;
+}
+
+bool menu_cache_load(uint8_t **data, size_t *size) {
+  if(!persist_exists(PersistKeyMenuCacheSize) || !persist_exists(PersistKeyMenuCacheHash)) {
+    return false;
+  }
+
+  const int32_t cached_size = persist_read_int(PersistKeyMenuCacheSize);
+  if(cached_size <= 0 || cached_size > MAX_SIZE) {
+    return false;
+  }
+
+  uint8_t *buffer = malloc(cached_size);
+  if(!buffer) {
+    return false;
+  }
+
+  bool valid = true;
+  for(int c = 0; valid && c < num_chunks(cached_size); c++) {
+    const size_t offset = c * PERSIST_DATA_MAX_LENGTH;
+    const size_t length = (cached_size - offset < PERSIST_DATA_MAX_LENGTH) ?
+                          (cached_size - offset) : PERSIST_DATA_MAX_LENGTH;
+    valid = persist_read_data(PersistKeyMenuCacheChunk + c, buffer + offset, length) == (int)length;
+  }
+
+  const uint32_t hash = (uint32_t)persist_read_int(PersistKeyMenuCacheHash);
+  if(!valid || menu_data_hash(buffer, cached_size, MENU_DATA_HASH_SEED) != hash) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Discarding invalid menu cache");
+    free(buffer);
+    return false;
+  }
+
+  *data = buffer;
+  *size = cached_size;
+  return true;
+}
+
+void menu_cache_store(const uint8_t *data, size_t size) {
+  // Invalidate first, so a store cut short leaves nothing half written
+  persist_delete(PersistKeyMenuCacheSize);
+  persist_delete(PersistKeyMenuCacheHash);
+  if(size > MAX_SIZE) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Menu definition too large to cache");
+    size = 0;
+  }
+
+  const int chunks = num_chunks(size);
+  for(int c = 0; c < chunks; c++) {
+    const size_t offset = c * PERSIST_DATA_MAX_LENGTH;
+    const size_t length = (size - offset < PERSIST_DATA_MAX_LENGTH) ? (size - offset) : PERSIST_DATA_MAX_LENGTH;
+    if(persist_write_data(PersistKeyMenuCacheChunk + c, data + offset, length) != (int)length) {
+      return;
+    }
+  }
+
+  // Release chunks a previous, larger definition left behind
+  for(int c = chunks; c < MENU_CACHE_MAX_CHUNKS; c++) {
+    if(persist_exists(PersistKeyMenuCacheChunk + c)) {
+      persist_delete(PersistKeyMenuCacheChunk + c);
+    }
+  }
+
+  if(size > 0) {
+    persist_write_int(PersistKeyMenuCacheHash, (int32_t)menu_data_hash(data, size, MENU_DATA_HASH_SEED));
+    persist_write_int(PersistKeyMenuCacheSize, size);
+  }
+}
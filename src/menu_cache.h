@@ -0,0 +1,15 @@
+#pragma once
+
+/**
+ * menu_cache.h - Keeps the last menu definition received from the phone in
+ * persistent storage, so a cold start can show it without waiting on
+ * Bluetooth
+ */
+
+#include <pebble.h>
+
+// Load the cached definition into a new buffer owned by the caller
+bool menu_cache_load(uint8_t **data, size_t *size);
+
+// Replace the cached definition, or drop it if it doesn't fit
+void menu_cache_store(const uint8_t *data, size_t size);
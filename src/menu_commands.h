@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * menu_commands.h - Menu items that run a command rather than play a
+ * vibration. Like vibration_types.h, the enum and default labels are
+ * generated from this one list, which tools/pack_menu.py and
+ * tools/gen_js_names.py also read.
+ *
+ * Columns: name, label. Commands are numbered by position in the MENU
+ * resource and synced definitions, so new ones go at the end.
+ */
+
+#define MENU_COMMANDS(X) \
+  X(ComposePulse,   "Add Pulse") \
+  X(ComposeGap,     "Add Gap") \
+  X(ComposeRepeat,  "Repeat All") \
+  X(ComposePlay,    "Play") \
+  X(ComposeClear,   "Clear") \
+  X(Every60s,       "Every Minute") \
+  X(StopRepeating,  "Cancel All") \
+  X(Every10s,       "Every 10 Seconds") \
+  X(Every30s,       "Every 30 Seconds") \
+  X(In1Minute,      "In 1 Minute") \
+  X(In5Minutes,     "In 5 Minutes") \
+  X(AssignUp,       "Last to Up") \
+  X(AssignUpLong,   "Last to Hold Up") \
+  X(AssignDown,     "Last to Down") \
+  X(AssignDownLong, "Last to Hold Down") \
+  X(DumpTrace,      "Dump Trace")
+
+#define MENU_COMMAND_ENUM(name, label) MenuCommand##name,
+
+typedef enum {
+  MENU_COMMANDS(MENU_COMMAND_ENUM)
+
+  MenuCommandCount
+} MenuCommand;
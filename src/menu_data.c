@@ -0,0 +1,138 @@
+/**
+ * menu_data.c - Walking and hashing the packed menu definition
+ */
+
+#include "menu_data.h"
+
+int menu_data_num_levels(const uint8_t *data, size_t size) {
+  if(!data || size < MENU_HEADER_SIZE || data[0] != MENU_MAGIC_0 || data[1] != MENU_MAGIC_1 ||
+     data[2] != MENU_VERSION) {
+    return 0;
+  }
+  return data[3];
+}
+
+size_t menu_data_record_length(const uint8_t *record, const uint8_t *end) {
+  if(record >= end) {
+    return 0;
+  }
+
+  const uint8_t num_items = record[0];
+  const uint8_t *cursor = record + 1;
+  for(int i = 0; i < num_items; i++) {
+    if(end - cursor < MENU_ITEM_HEADER_SIZE) {
+      return 0;
+    }
+    cursor += MENU_ITEM_HEADER_SIZE + cursor[2];
+    if(cursor > end) {
+      return 0;
+    }
+  }
+  return cursor - record;
+}
+
+int menu_data_index(const uint8_t *data, size_t size, MenuRecord *records, int max_records) {
+  const int num_levels = menu_data_num_levels(data, size);
+  if(num_levels == 0 || num_levels > max_records) {
+    return 0;
+  }
+
+  const uint8_t *end = data + size;
+  size_t offset = MENU_HEADER_SIZE;
+  for(int l = 0; l < num_levels; l++) {
+    const size_t length = menu_data_record_length(data + offset, end);
+    if(length == 0 || offset + length > UINT16_MAX) {
+      return 0;
+    }
+    records[l] = (MenuRecord) {
+      .offset = offset,
+      .length = length,
+    };
+    offset += length;
+  }
+  return num_levels;
+}
+
+uint32_t menu_data_hash(const uint8_t *bytes, size_t length, uint32_t seed) {
+  uint32_t hash = seed;
+  for(size_t i = 0; i < length; i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void menu_data_write_header(uint8_t *data, int num_levels) {
+  data[0] = MENU_MAGIC_0;
+  data[1] = MENU_MAGIC_1;
+  data[2] = MENU_VERSION;
+  data[3] = num_levels;
+}
+
+const uint8_t *menu_data_find_record(const uint8_t *data, size_t size, int index, size_t *length) {
+  if(index < 0 || index >= menu_data_num_levels(data, size)) {
+    return NULL;
+  }
+
+  const uint8_t *end = data + size;
+  const uint8_t *record = data + MENU_HEADER_SIZE;
+  for(int l = 0; l <= index; l++) {
+    *length = menu_data_record_length(record, end);
+    if(*length == 0) {
+      return NULL;
+    }
+    if(l < index) {
+      record += *length;
+    }
+  }
+  return record;
+}
+
+static bool validate_item(const uint8_t *item, int level_index, int num_types, int num_commands) {
+  const uint8_t value = item[1];
+  const uint8_t label_length = item[2];
+  if(label_length > 0 && item[MENU_ITEM_HEADER_SIZE + label_length - 1] != '\0') {
+    return false;
+  }
+
+  switch(item[0]) {
+    case MenuItemKindAction:  return value < num_types;
+    case MenuItemKindCommand: return value < num_commands;
+    case MenuItemKindChild:   return value < level_index && label_length > 0;
+    default:                  return false;
+  }
+}
+
+bool menu_data_validate(const uint8_t *data, size_t size, int num_types, int num_commands, int max_depth) {
+  const int num_levels = menu_data_num_levels(data, size);
+  if(num_levels == 0) {
+    return false;
+  }
+
+  // Children come first, so each level's height is known before its parent's
+  uint8_t heights[MENU_MAX_LEVELS];
+  const uint8_t *end = data + size;
+  const uint8_t *record = data + MENU_HEADER_SIZE;
+  for(int l = 0; l < num_levels; l++) {
+    const size_t length = menu_data_record_length(record, end);
+    if(length == 0) {
+      return false;
+    }
+
+    heights[l] = 0;
+    const uint8_t *item = record + 1;
+    for(int i = 0; i < record[0]; i++) {
+      if(!validate_item(item, l, num_types, num_commands)) {
+        return false;
+      }
+      if(item[0] == MenuItemKindChild && heights[item[1]] + 1 > heights[l]) {
+        heights[l] = heights[item[1]] + 1;
+      }
+      item += MENU_ITEM_HEADER_SIZE + item[2];
+    }
+    record += length;
+  }
+
+  // The root is the last record
+  return heights[num_levels - 1] <= max_depth;
+}
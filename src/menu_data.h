@@ -0,0 +1,57 @@
+#pragma once
+
+/**
+ * menu_data.h - Layout of the packed menu definition shared by the MENU
+ * resource, tools/pack_menu.py and the phone sync, plus helpers for walking
+ * and hashing its level records.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MENU_MAGIC_0 'A'
+#define MENU_MAGIC_1 'M'
+#define MENU_VERSION 1
+#define MENU_HEADER_SIZE 4
+#define MENU_ITEM_HEADER_SIZE 3
+#define MENU_MAX_LEVELS 255
+
+// Deepest level a definition may have, counting the root as depth 0
+#define MENU_MAX_DEPTH 8
+
+typedef enum {
+  MenuItemKindAction,
+  MenuItemKindChild,
+  MenuItemKindCommand
+} MenuItemKind;
+
+// Location of one level record within a packed definition
+typedef struct {
+  uint16_t offset;
+  uint16_t length;
+} MenuRecord;
+
+// Check the header, returning the number of level records or 0 if unsupported
+int menu_data_num_levels(const uint8_t *data, size_t size);
+
+// Length of the level record starting at record, or 0 if it overruns end
+size_t menu_data_record_length(const uint8_t *record, const uint8_t *end);
+
+// Locate every level record, returning the number found or 0 if malformed
+int menu_data_index(const uint8_t *data, size_t size, MenuRecord *records, int max_records);
+
+// FNV-1a hash, used for level records and for whole definitions
+uint32_t menu_data_hash(const uint8_t *bytes, size_t length, uint32_t seed);
+
+#define MENU_DATA_HASH_SEED 2166136261u
+
+// Write the header for a definition of num_levels records
+void menu_data_write_header(uint8_t *data, int num_levels);
+
+// Find level record index, returning its start or NULL if it doesn't exist
+const uint8_t *menu_data_find_record(const uint8_t *data, size_t size, int index, size_t *length);
+
+// Check every record and item: values in range, labels terminated, children
+// before their parents and no level deeper than max_depth below the root
+bool menu_data_validate(const uint8_t *data, size_t size, int num_types, int num_commands, int max_depth);
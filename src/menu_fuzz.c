@@ -0,0 +1,244 @@
+/**
+ * menu_fuzz.c - Generates random menu definitions and drives the fuzz
+ * iterations from an app_timer
+ */
+
+#include "menu_fuzz.h"
+
+#if FUZZ_MENU
+
+#include "menu.h"
+#include "menu_build.h"
+#include "menu_data.h"
+
+#define STEP_MS 200
+
+// Small enough that a definition and the levels built from it fit on aplite.
+// Levels may be too wide to show inline and labels may run past
+// MENU_COST_LABEL_SIZE, to exercise portals and cutting labels short.
+#define MAX_WIDTH (MENU_INLINE_MAX_WIDTH + 2)
+#define MAX_LEVELS 24
+#define MAX_LABEL_LENGTH 40
+
+typedef enum {
+  FuzzStepOpen,
+  FuzzStepClose,
+  FuzzStepCheck,
+
+  FuzzStepCount
+} FuzzStep;
+
+typedef struct {
+  uint8_t kind;
+  uint8_t value;
+  uint8_t label_length;
+} FuzzItem;
+
+static uint32_t s_random;
+
+// Where the definition is written, NULL while it is only being measured
+static uint8_t *s_cursor;
+static size_t s_size;
+static int s_num_levels;
+static int s_reserved_levels;
+
+static bool s_flatten;
+static FuzzStep s_step;
+static int s_iteration;
+static uint32_t s_seed;
+static size_t s_baseline, s_used_before;
+static int s_levels_built, s_capacity_errors, s_failed_builds, s_failed_opens, s_leaking_iterations;
+
+/********************************* Generation *********************************/
+
+static uint32_t random_below(uint32_t bound) {
+  // xorshift32, so a seed gives the same tree on every platform
+  s_random ^= s_random << 13;
+  s_random ^= s_random >> 17;
+  s_random ^= s_random << 5;
+  return s_random % bound;
+}
+
+static void write_byte(uint8_t byte) {
+  if(s_cursor) {
+    *s_cursor++ = byte;
+  }
+  s_size++;
+}
+
+static int generate_level(int depth) {
+  FuzzItem items[MAX_WIDTH];
+  const int num_items = 1 + random_below(MAX_WIDTH);
+  for(int i = 0; i < num_items; i++) {
+    FuzzItem *item = &items[i];
+    item->kind = random_below(MenuItemKindCommand + 1);
+    if(item->kind == MenuItemKindChild && (depth == MENU_MAX_DEPTH || s_reserved_levels == MAX_LEVELS)) {
+      item->kind = MenuItemKindAction;
+    }
+
+    // Lengths count the terminator, 0 leaves an action or command its default label
+    switch(item->kind) {
+      case MenuItemKindChild:
+        // Written before the parent, so its index is always the lower
+        s_reserved_levels++;
+        item->value = generate_level(depth + 1);
+        item->label_length = 1 + random_below(MAX_LABEL_LENGTH);
+        break;
+      case MenuItemKindCommand:
+        item->value = random_below(MenuCommandCount);
+        item->label_length = random_below(MAX_LABEL_LENGTH + 1);
+        break;
+      default:
+        item->value = random_below(VibrationTypeCount);
+        item->label_length = random_below(MAX_LABEL_LENGTH + 1);
+        break;
+    }
+  }
+
+  write_byte(num_items);
+  for(int i = 0; i < num_items; i++) {
+    write_byte(items[i].kind);
+    write_byte(items[i].value);
+    write_byte(items[i].label_length);
+    for(int c = 1; c < items[i].label_length; c++) {
+      write_byte('a' + random_below(26));
+    }
+    if(items[i].label_length) {
+      write_byte('\0');
+    }
+  }
+  return s_num_levels++;
+}
+
+static void generate_tree(uint32_t seed, uint8_t *data) {
+  s_random = seed * 2654435761u;
+  s_cursor = data ? data + MENU_HEADER_SIZE : NULL;
+  s_size = MENU_HEADER_SIZE;
+  s_num_levels = 0;
+  s_reserved_levels = 1;
+  generate_level(0);
+}
+
+static uint8_t *generate_definition(uint32_t seed, size_t *size) {
+  // Measure the tree, then generate it again from the same seed into the buffer
+  generate_tree(seed, NULL);
+  uint8_t *data = malloc(s_size);
+  if(!data) {
+    return NULL;
+  }
+  generate_tree(seed, data);
+  menu_data_write_header(data, s_num_levels);
+  *size = s_size;
+  return data;
+}
+
+/********************************* Iterations *********************************/
+
+static void open_step() {
+  s_seed = FUZZ_MENU_SEED + s_iteration;
+  size_t size;
+  uint8_t *data = generate_definition(s_seed, &size);
+  if(!data) {
+    s_failed_opens++;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "fuzz: seed %u, no room for the definition", (unsigned)s_seed);
+    return;
+  }
+
+  const int num_levels = s_num_levels;
+  menu_set_flatten(random_below(2));
+  menu_set_definition(data, size);
+
+  // The definition stays resident until the next one, so it counts in both
+  s_used_before = heap_bytes_used();
+  if(!menu_open()) {
+    s_failed_opens++;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "fuzz: seed %u failed to open, %d levels in %u bytes, %u free",
+            (unsigned)s_seed, num_levels, (unsigned)size, (unsigned)heap_bytes_free());
+  }
+}
+
+static bool check_heap(const char *stage) {
+  const size_t used = heap_bytes_used();
+  if(used == s_used_before) {
+    return false;
+  }
+  APP_LOG(APP_LOG_LEVEL_WARNING, "fuzz: seed %u heap drift %d after %s", (unsigned)s_seed,
+          (int)used - (int)s_used_before, stage);
+  return true;
+}
+
+static void check_step() {
+  if(menu_is_open()) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "fuzz: seed %u still open", (unsigned)s_seed);
+  }
+
+  // Portal levels are only built once chosen, so build every one of them too
+  bool drifted = check_heap("menu");
+  if(!menu_build_every_frame()) {
+    s_failed_opens++;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "fuzz: seed %u failed to build its frames, %u free", (unsigned)s_seed,
+            (unsigned)heap_bytes_free());
+  }
+  drifted |= check_heap("frames");
+  if(drifted) {
+    s_leaking_iterations++;
+  }
+  s_iteration++;
+}
+
+static void finish() {
+  menu_set_definition(NULL, 0);
+  menu_set_flatten(s_flatten);
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "fuzz: %d iterations, %d levels, %d capacity errors, %d failed builds, "
+          "%d failed opens, %d with heap drift, final delta=%d", s_iteration, s_levels_built,
+          s_capacity_errors, s_failed_builds, s_failed_opens, s_leaking_iterations,
+          (int)heap_bytes_used() - (int)s_baseline);
+}
+
+static void step_timer_callback(void *context) {
+  switch(s_step) {
+    case FuzzStepOpen:  open_step();                              break;
+    case FuzzStepClose: if(menu_is_open()) { menu_close(false); } break;
+    case FuzzStepCheck: check_step();                             break;
+    default: break;
+  }
+
+  s_step = (s_step + 1) % FuzzStepCount;
+  if(s_step == FuzzStepOpen && s_iteration == FUZZ_MENU_ITERATIONS) {
+    finish();
+  } else {
+    app_timer_register(STEP_MS, step_timer_callback, NULL);
+  }
+}
+
+void menu_fuzz_start(bool flatten) {
+  s_flatten = flatten;
+  s_step = FuzzStepOpen;
+  s_iteration = 0;
+  s_levels_built = 0;
+  s_capacity_errors = 0;
+  s_failed_builds = 0;
+  s_failed_opens = 0;
+  s_leaking_iterations = 0;
+  s_baseline = heap_bytes_used();
+
+  app_timer_register(STEP_MS, step_timer_callback, NULL);
+}
+
+void menu_fuzz_level_built(int capacity, int num_added, bool valid) {
+  s_levels_built++;
+
+  // Room left over, or an add refused once the level was full
+  if(valid ? (num_added != capacity) : (num_added == capacity)) {
+    s_capacity_errors++;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "fuzz: seed %u level of capacity %d with %d added%s", (unsigned)s_seed,
+            capacity, num_added, valid ? "" : " and more refused");
+  } else if(!valid) {
+    s_failed_builds++;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "fuzz: seed %u level abandoned, %u free", (unsigned)s_seed,
+            (unsigned)heap_bytes_free());
+  }
+}
+
+#endif
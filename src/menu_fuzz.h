@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * menu_fuzz.h - Optional menu fuzzing mode, enabled with FUZZ_MENU in
+ * config.h. Each iteration generates a random definition of up to
+ * MENU_MAX_DEPTH levels deep, with random widths, item kinds and label
+ * lengths, then opens and closes the ActionMenu built from it and builds and
+ * releases every frame its portals open. Heap usage is compared before and
+ * after, and every level built must have been created with exactly the
+ * capacity its items fill.
+ */
+
+#include <pebble.h>
+
+#include "config.h"
+
+#if FUZZ_MENU
+
+#define MENU_FUZZ_START(flatten) menu_fuzz_start(flatten)
+#define MENU_FUZZ_LEVEL_BUILT_HANDLER menu_fuzz_level_built
+
+// Start the iterations, flatten is the setting restored once they finish
+void menu_fuzz_start(bool flatten);
+
+// MenuBuilder level_built handler, checks each level filled its capacity
+void menu_fuzz_level_built(int capacity, int num_added, bool valid);
+
+#else
+
+#define MENU_FUZZ_START(flatten)
+#define MENU_FUZZ_LEVEL_BUILT_HANDLER NULL
+
+#endif
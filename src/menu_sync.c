@@ -0,0 +1,244 @@
+/**
+ * menu_sync.c - Level-by-level menu definition sync with the phone
+ *
+ * 1. Phone sends MenuVersion with MenuLevelHashes, one little-endian uint32
+ *    FNV-1a hash per level record.
+ * 2. Watch replies with MenuNeeded, a bitmask of the levels it has no record
+ *    for. Records are matched by hash, so moved levels don't need resending.
+ * 3. Phone sends the needed records in MenuLevels batches, each record being
+ *    <index> <length low> <length high> <record bytes>.
+ * 4. Once every level is present the new definition is assembled and handed
+ *    over, unchanged records having been copied from the current one.
+ */
+
+#include "menu_sync.h"
+
+#include "menu_data.h"
+
+// Must match appKeys in appinfo.json
+typedef enum {
+  AppKeyMenuVersion = 0,
+  AppKeyMenuLevelHashes = 1,
+  AppKeyMenuNeeded = 2,
+  AppKeyMenuLevels = 3
+} AppKey;
+
+#define INBOX_SIZE 512
+#define OUTBOX_SIZE 64
+#define LEVEL_BATCH_HEADER_SIZE 3
+
+typedef struct {
+  uint32_t hash;
+  uint8_t *data;
+  uint16_t length;
+} StagedRecord;
+
+static MenuSyncUpdatedHandler s_updated_handler;
+
+static const uint8_t *s_current_data;
+static size_t s_current_size;
+static uint32_t s_current_version;
+
+// The definition being received
+static uint32_t s_staged_version;
+static StagedRecord *s_staged_records;
+static int s_staged_num_levels;
+static int s_staged_missing;
+
+static uint32_t version_of(const uint32_t *hashes, int num_levels) {
+  return menu_data_hash((const uint8_t *)hashes, num_levels * sizeof(uint32_t), MENU_DATA_HASH_SEED);
+}
+
+static void discard_staged() {
+  for(int l = 0; l < s_staged_num_levels; l++) {
+    free(s_staged_records[l].data);
+  }
+  free(s_staged_records);
+  s_staged_records = NULL;
+  s_staged_num_levels = 0;
+  s_staged_missing = 0;
+}
+
+static bool stage_record(StagedRecord *staged, const uint8_t *record, size_t length) {
+  staged->data = malloc(length);
+  if(!staged->data) {
+    return false;
+  }
+  memcpy(staged->data, record, length);
+  staged->length = length;
+  s_staged_missing--;
+  return true;
+}
+
+static void commit_staged() {
+  size_t size = MENU_HEADER_SIZE;
+  for(int l = 0; l < s_staged_num_levels; l++) {
+    size += s_staged_records[l].length;
+  }
+
+  uint8_t *data = malloc(size);
+  if(data) {
+    menu_data_write_header(data, s_staged_num_levels);
+    size_t offset = MENU_HEADER_SIZE;
+    for(int l = 0; l < s_staged_num_levels; l++) {
+      memcpy(data + offset, s_staged_records[l].data, s_staged_records[l].length);
+      offset += s_staged_records[l].length;
+    }
+  }
+  discard_staged();
+
+  if(data) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "Menu definition updated to %08lx", (unsigned long)s_staged_version);
+    s_updated_handler(data, size);
+  }
+}
+
+static void send_needed() {
+  DictionaryIterator *iter;
+  if(app_message_outbox_begin(&iter) != APP_MSG_OK) {
+    return;
+  }
+
+  uint8_t needed[(MENU_MAX_LEVELS + 7) / 8] = {0};
+  for(int l = 0; l < s_staged_num_levels; l++) {
+    if(!s_staged_records[l].data) {
+      needed[l / 8] |= 1 << (l % 8);
+    }
+  }
+  dict_write_uint32(iter, AppKeyMenuVersion, s_staged_version);
+  dict_write_data(iter, AppKeyMenuNeeded, needed, (s_staged_num_levels + 7) / 8);
+  app_message_outbox_send();
+}
+
+static void handle_level_hashes(uint32_t version, const Tuple *hashes_tuple) {
+  discard_staged();
+  if(version == s_current_version) {
+    return;
+  }
+
+  const int num_levels = hashes_tuple->length / sizeof(uint32_t);
+  if(num_levels == 0 || num_levels > MENU_MAX_LEVELS) {
+    return;
+  }
+
+  const int max_current = menu_data_num_levels(s_current_data, s_current_size);
+  MenuRecord *current = malloc(max_current * sizeof(MenuRecord));
+  const int num_current = current ? menu_data_index(s_current_data, s_current_size, current, max_current) : 0;
+
+  s_staged_records = calloc(num_levels, sizeof(StagedRecord));
+  if(!s_staged_records) {
+    free(current);
+    return;
+  }
+  s_staged_version = version;
+  s_staged_num_levels = num_levels;
+  s_staged_missing = num_levels;
+
+  // Take every record we already have a copy of, wherever it sits now
+  for(int l = 0; l < num_levels; l++) {
+    uint32_t hash;
+    memcpy(&hash, &hashes_tuple->value->data[l * sizeof(uint32_t)], sizeof(hash));
+    s_staged_records[l].hash = hash;
+
+    for(int c = 0; c < num_current; c++) {
+      const uint8_t *record = s_current_data + current[c].offset;
+      if(menu_data_hash(record, current[c].length, MENU_DATA_HASH_SEED) == hash) {
+        if(!stage_record(&s_staged_records[l], record, current[c].length)) {
+          free(current);
+          discard_staged();
+          return;
+        }
+        break;
+      }
+    }
+  }
+  free(current);
+
+  if(s_staged_missing == 0) {
+    commit_staged();
+  } else {
+    send_needed();
+  }
+}
+
+static void handle_levels(uint32_t version, const Tuple *levels_tuple) {
+  // Drop batches for a definition we are no longer receiving
+  if(!s_staged_records || version != s_staged_version) {
+    return;
+  }
+
+  const uint8_t *cursor = levels_tuple->value->data;
+  const uint8_t *end = cursor + levels_tuple->length;
+  while(end - cursor >= LEVEL_BATCH_HEADER_SIZE) {
+    const uint8_t index = cursor[0];
+    const uint16_t length = cursor[1] | (cursor[2] << 8);
+    const uint8_t *record = cursor + LEVEL_BATCH_HEADER_SIZE;
+    cursor = record + length;
+    if(cursor > end || index >= s_staged_num_levels) {
+      break;
+    }
+
+    StagedRecord *staged = &s_staged_records[index];
+    if(staged->data || menu_data_record_length(record, record + length) != length ||
+       menu_data_hash(record, length, MENU_DATA_HASH_SEED) != staged->hash) {
+      APP_LOG(APP_LOG_LEVEL_WARNING, "Ignoring menu level %d", index);
+      continue;
+    }
+    if(!stage_record(staged, record, length)) {
+      discard_staged();
+      return;
+    }
+  }
+
+  if(s_staged_missing == 0) {
+    commit_staged();
+  }
+}
+
+static void inbox_received_handler(DictionaryIterator *iter, void *context) {
+  const Tuple *version_tuple = dict_find(iter, AppKeyMenuVersion);
+  if(!version_tuple) {
+    return;
+  }
+
+  const uint32_t version = version_tuple->value->uint32;
+  const Tuple *hashes_tuple = dict_find(iter, AppKeyMenuLevelHashes);
+  if(hashes_tuple) {
+    handle_level_hashes(version, hashes_tuple);
+  }
+
+  const Tuple *levels_tuple = dict_find(iter, AppKeyMenuLevels);
+  if(levels_tuple) {
+    handle_levels(version, levels_tuple);
+  }
+}
+
+void menu_sync_init(MenuSyncUpdatedHandler handler) {
+  s_updated_handler = handler;
+  app_message_register_inbox_received(inbox_received_handler);
+  app_message_open(INBOX_SIZE, OUTBOX_SIZE);
+}
+
+void menu_sync_deinit() {
+  discard_staged();
+}
+
+void menu_sync_set_current(const uint8_t *data, size_t size) {
+  s_current_data = data;
+  s_current_size = size;
+
+  // Versions are derived from the record hashes, exactly as the phone does
+  s_current_version = 0;
+  const int max_levels = menu_data_num_levels(data, size);
+  MenuRecord *records = malloc(max_levels * sizeof(MenuRecord));
+  uint32_t *hashes = malloc(max_levels * sizeof(uint32_t));
+  const int num_levels = (records && hashes) ? menu_data_index(data, size, records, max_levels) : 0;
+  if(num_levels > 0) {
+    for(int l = 0; l < num_levels; l++) {
+      hashes[l] = menu_data_hash(data + records[l].offset, records[l].length, MENU_DATA_HASH_SEED);
+    }
+    s_current_version = version_of(hashes, num_levels);
+  }
+  free(hashes);
+  free(records);
+}
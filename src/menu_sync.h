@@ -0,0 +1,18 @@
+#pragma once
+
+/**
+ * menu_sync.h - Receives menu definitions pushed by the phone over
+ * AppMessage. The phone first sends a hash per level record; only records the
+ * watch doesn't already hold are then requested and sent in batches.
+ */
+
+#include <pebble.h>
+
+// Called with a complete new definition, ownership passes to the handler
+typedef void (*MenuSyncUpdatedHandler)(uint8_t *data, size_t size);
+
+void menu_sync_init(MenuSyncUpdatedHandler handler);
+void menu_sync_deinit(void);
+
+// The newest definition held, used to reuse records that haven't changed
+void menu_sync_set_current(const uint8_t *data, size_t size);
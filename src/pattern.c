@@ -0,0 +1,63 @@
+/**
+ * pattern.c - Expanding and scaling custom vibration patterns
+ */
+
+#include "pattern.h"
+
+uint32_t pattern_expand(const PatternSpec *spec, uint32_t *segments, uint32_t max_segments) {
+  // Segments alternate on and off starting with on, so a zero-length on pulse
+  // or a trailing off gap would only occupy a slot in the vibe queue
+  uint32_t num_segments = 0;
+  if(spec->on_ms == 0) {
+    return 0;
+  }
+
+  for(int i = 0; i < spec->repeat; i++) {
+    if(num_segments > 0 && spec->off_ms == 0) {
+      // Back-to-back pulses merge into one longer segment
+      segments[num_segments - 1] += spec->on_ms;
+      continue;
+    }
+
+    // Every pulse after the first needs its gap queued before it
+    const uint32_t needed = (num_segments > 0) ? 2 : 1;
+    if(num_segments + needed > max_segments) {
+      break;
+    }
+    if(num_segments > 0) {
+      segments[num_segments++] = spec->off_ms;
+    }
+    segments[num_segments++] = spec->on_ms;
+  }
+  return num_segments;
+}
+
+PatternSpec pattern_scale(const PatternSpec *spec, PatternPower power, uint32_t scale_percent) {
+  PatternSpec scaled = *spec;
+  if(power == PatternPowerFull) {
+    return scaled;
+  }
+
+  scaled.on_ms = spec->on_ms * scale_percent / 100;
+  scaled.off_ms = spec->off_ms * scale_percent / 100;
+  if(power == PatternPowerMinimal && scaled.repeat > 1) {
+    scaled.repeat = 1;
+  }
+  return scaled;
+}
+
+uint32_t pattern_on_time_ms(const uint32_t *segments, uint32_t num_segments) {
+  uint32_t on_ms = 0;
+  for(uint32_t i = 0; i < num_segments; i += 2) {
+    on_ms += segments[i];
+  }
+  return on_ms;
+}
+
+uint32_t pattern_duration_ms(const uint32_t *segments, uint32_t num_segments) {
+  uint32_t duration_ms = 0;
+  for(uint32_t i = 0; i < num_segments; i++) {
+    duration_ms += segments[i];
+  }
+  return duration_ms;
+}
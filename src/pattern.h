@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * pattern.h - Custom vibration patterns described as an on/off pair played a
+ * number of times, and their expansion into the segment list the vibe driver
+ * takes. Kept free of pebble.h so it builds anywhere.
+ */
+
+#include <stdint.h>
+
+// Upper bound on the segments a single spec expands to
+#define PATTERN_MAX_SEGMENTS 16
+
+typedef struct {
+  uint16_t on_ms;
+  uint16_t off_ms;
+  uint8_t repeat;
+} PatternSpec;
+
+// How much of a pattern the battery can currently afford
+typedef enum {
+  PatternPowerFull,
+  PatternPowerReduced,         // Durations scaled down
+  PatternPowerMinimal,         // A single scaled pulse
+} PatternPower;
+
+// Write alternating on/off segments, starting with on, returning how many
+uint32_t pattern_expand(const PatternSpec *spec, uint32_t *segments, uint32_t max_segments);
+
+// The spec cut down to what the power level allows, by scale_percent of its durations
+PatternSpec pattern_scale(const PatternSpec *spec, PatternPower power, uint32_t scale_percent);
+
+// Total time the motor is on across expanded segments
+uint32_t pattern_on_time_ms(const uint32_t *segments, uint32_t num_segments);
+
+// Time from the first pulse starting to the last one ending
+uint32_t pattern_duration_ms(const uint32_t *segments, uint32_t num_segments);
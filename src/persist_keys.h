@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * persist_keys.h - Every persistent storage key used by the app, kept in one
+ * place so ranges can't overlap
+ */
+
+typedef enum {
+  PersistKeyLastType = 0,
+  PersistKeyUsageCounts = 1,
+
+  // Types background jobs were due to play while the app was closed, a byte
+  // each in the order they fell due, written by the worker before it launches
+  // the app
+  PersistKeyWorkerPendingTypes = 2,
+
+  // VibrationType assigned to each button shortcut, see shortcuts.c
+  PersistKeyShortcuts = 3,
+
+  // Cached menu definition, see menu_cache.c
+  PersistKeyMenuCacheSize = 10,
+  PersistKeyMenuCacheHash = 11,
+  PersistKeyMenuCacheChunk = 12    // First of MENU_CACHE_MAX_CHUNKS consecutive keys
+} PersistKey;
+
+#define MENU_CACHE_MAX_CHUNKS 12
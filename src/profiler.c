@@ -0,0 +1,100 @@
+/**
+ * profiler.c - Groups update proc calls into frames by closing each frame on
+ * the next turn of the event loop, after the render pass has finished
+ */
+
+#include "profiler.h"
+
+#include "time_util.h"
+
+#if PROFILE_FRAMES
+
+// Interval between animation frames
+#define FRAME_INTERVAL_MS 33
+
+// How long after an open or close frames are expected at the animation rate
+#define TRANSITION_MS 500
+
+static uint64_t s_frame_start_ms;
+static uint64_t s_frame_draw_ms;
+static uint64_t s_draw_start_ms;
+static uint64_t s_last_frame_ms;
+static uint64_t s_transition_end_ms;
+static uint64_t s_menu_open_ms;
+static uint8_t s_frame_draws;
+static bool s_in_frame;
+
+static uint32_t s_num_frames;
+static uint32_t s_total_draw_ms;
+static uint32_t s_max_draw_ms;
+static uint32_t s_dropped_frames;
+static uint32_t s_num_opens;
+static uint32_t s_num_closes;
+static uint32_t s_total_open_ms;
+
+static void end_frame(void *context) {
+  s_in_frame = false;
+  const uint32_t draw_ms = s_frame_draw_ms;
+  const uint32_t gap_ms = s_last_frame_ms ? s_frame_start_ms - s_last_frame_ms : 0;
+
+  // A late frame during a transition stands for every frame it replaced
+  uint32_t dropped = 0;
+  if(s_frame_start_ms <= s_transition_end_ms && gap_ms > FRAME_INTERVAL_MS) {
+    dropped = gap_ms / FRAME_INTERVAL_MS - 1;
+  }
+
+  s_num_frames++;
+  s_total_draw_ms += draw_ms;
+  if(draw_ms > s_max_draw_ms) {
+    s_max_draw_ms = draw_ms;
+  }
+  s_dropped_frames += dropped;
+  s_last_frame_ms = s_frame_start_ms;
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "profile: frame %u draw=%ums layers=%u gap=%ums dropped=%u",
+          (unsigned)s_num_frames, (unsigned)draw_ms, s_frame_draws, (unsigned)gap_ms, (unsigned)dropped);
+}
+
+void profiler_draw_begin() {
+  s_draw_start_ms = time_util_now_ms();
+  if(!s_in_frame) {
+    s_in_frame = true;
+    s_frame_start_ms = s_draw_start_ms;
+    s_frame_draw_ms = 0;
+    s_frame_draws = 0;
+    app_timer_register(0, end_frame, NULL);
+  }
+}
+
+void profiler_draw_end() {
+  s_frame_draw_ms += time_util_now_ms() - s_draw_start_ms;
+  s_frame_draws++;
+}
+
+void profiler_menu_open() {
+  // The main Window is covered while open, so don't count that as dropped frames
+  s_menu_open_ms = time_util_now_ms();
+  s_transition_end_ms = s_menu_open_ms + TRANSITION_MS;
+  s_last_frame_ms = 0;
+  s_num_opens++;
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "profile: menu open");
+}
+
+void profiler_menu_did_close() {
+  // Waiting from here to the first redraw counts against the budget
+  const uint64_t now = time_util_now_ms();
+  const uint32_t open_ms = s_menu_open_ms ? now - s_menu_open_ms : 0;
+  s_total_open_ms += open_ms;
+  s_transition_end_ms = now + TRANSITION_MS;
+  s_last_frame_ms = now;
+  s_num_closes++;
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "profile: menu did_close after %ums", (unsigned)open_ms);
+}
+
+void profiler_report() {
+  APP_LOG(APP_LOG_LEVEL_INFO, "profile: frames=%u mean=%ums max=%ums dropped=%u opens=%u closes=%u mean_open=%ums",
+          (unsigned)s_num_frames, (unsigned)(s_num_frames ? s_total_draw_ms / s_num_frames : 0),
+          (unsigned)s_max_draw_ms, (unsigned)s_dropped_frames, (unsigned)s_num_opens, (unsigned)s_num_closes,
+          (unsigned)(s_num_closes ? s_total_open_ms / s_num_closes : 0));
+}
+
+#endif
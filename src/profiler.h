@@ -0,0 +1,41 @@
+#pragma once
+
+/**
+ * profiler.h - Optional frame profiler, enabled with PROFILE_FRAMES in
+ * config.h. The main Window's update procs are bracketed to time each frame,
+ * and ActionMenu opens and closes are recorded so frames arriving late around
+ * those transitions count as dropped. A summary is logged at exit.
+ */
+
+#include <pebble.h>
+
+#include "config.h"
+
+#if PROFILE_FRAMES
+
+#define PROFILE_DRAW_BEGIN() profiler_draw_begin()
+#define PROFILE_DRAW_END() profiler_draw_end()
+#define PROFILE_MENU_OPEN() profiler_menu_open()
+#define PROFILE_MENU_DID_CLOSE() profiler_menu_did_close()
+#define PROFILE_REPORT() profiler_report()
+
+// Bracket the body of an update proc, draws in the same render pass are one frame
+void profiler_draw_begin(void);
+void profiler_draw_end(void);
+
+// Call alongside action_menu_open and from the ActionMenu's did_close handler
+void profiler_menu_open(void);
+void profiler_menu_did_close(void);
+
+// Log totals for the whole run
+void profiler_report(void);
+
+#else
+
+#define PROFILE_DRAW_BEGIN()
+#define PROFILE_DRAW_END()
+#define PROFILE_MENU_OPEN()
+#define PROFILE_MENU_DID_CLOSE()
+#define PROFILE_REPORT()
+
+#endif
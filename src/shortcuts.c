@@ -0,0 +1,38 @@
+/**
+ * shortcuts.c - Assignments are stored as one byte per shortcut
+ */
+
+#include "shortcuts.h"
+
+#include "persist_keys.h"
+
+static uint8_t s_types[ShortcutCount] = {
+  [ShortcutUp] = VibrationTypeShort,
+  [ShortcutUpLong] = VibrationTypeLong,
+  [ShortcutDown] = VibrationTypeDouble,
+  [ShortcutDownLong] = VibrationTypeCustomMedium,
+};
+
+void shortcuts_init() {
+  uint8_t stored[ShortcutCount];
+  if(persist_read_data(PersistKeyShortcuts, stored, sizeof(stored)) != sizeof(stored)) {
+    return;
+  }
+
+  // Anything out of range, such as a type since removed, becomes unassigned
+  for(int i = 0; i < ShortcutCount; i++) {
+    s_types[i] = (stored[i] < VibrationTypeCount) ? stored[i] : VibrationTypeCount;
+  }
+}
+
+VibrationType shortcuts_get(Shortcut shortcut) {
+  return (shortcut < ShortcutCount) ? (VibrationType)s_types[shortcut] : VibrationTypeCount;
+}
+
+void shortcuts_set(Shortcut shortcut, VibrationType type) {
+  if(shortcut >= ShortcutCount || s_types[shortcut] == type) {
+    return;
+  }
+  s_types[shortcut] = type;
+  persist_write_data(PersistKeyShortcuts, s_types, sizeof(s_types));
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * shortcuts.h - The vibration type assigned to each of UP and DOWN, pressed
+ * and held, which play without opening the menu. Assignments persist.
+ */
+
+#include <pebble.h>
+
+#include "vibration_types.h"
+
+typedef enum {
+  ShortcutUp,
+  ShortcutUpLong,
+  ShortcutDown,
+  ShortcutDownLong,
+  ShortcutCount
+} Shortcut;
+
+// Read the assignments, falling back to defaults for any never set
+void shortcuts_init(void);
+
+// The assigned type, or VibrationTypeCount if none
+VibrationType shortcuts_get(Shortcut shortcut);
+
+void shortcuts_set(Shortcut shortcut, VibrationType type);
@@ -0,0 +1,48 @@
+/**
+ * status_layer.c - Draws the active vibration type's default label
+ */
+
+#include "status_layer.h"
+
+#include "profiler.h"
+
+typedef struct {
+  GFont font;
+  VibrationType type;
+} StatusLayerData;
+
+static void update_proc(Layer *layer, GContext *ctx) {
+  PROFILE_DRAW_BEGIN();
+  const StatusLayerData *data = layer_get_data(layer);
+  if(data->type < VibrationTypeCount) {
+    graphics_context_set_text_color(ctx, GColorBlack);
+    graphics_draw_text(ctx, vibration_type_get_label(data->type), data->font, layer_get_bounds(layer),
+                       GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
+  }
+  PROFILE_DRAW_END();
+}
+
+Layer *status_layer_create(GRect frame) {
+  Layer *layer = layer_create_with_data(frame, sizeof(StatusLayerData));
+  if(!layer) {
+    return NULL;
+  }
+
+  StatusLayerData *data = layer_get_data(layer);
+  data->font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+  data->type = VibrationTypeCount;
+  layer_set_update_proc(layer, update_proc);
+  return layer;
+}
+
+void status_layer_destroy(Layer *layer) {
+  layer_destroy(layer);
+}
+
+void status_layer_set_type(Layer *layer, VibrationType type) {
+  StatusLayerData *data = layer_get_data(layer);
+  if(data->type != type) {
+    data->type = type;
+    layer_mark_dirty(layer);
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+/**
+ * status_layer.h - A one line Layer naming the active vibration type. Setting
+ * the type only marks this Layer dirty, leaving the rest of the Window alone.
+ */
+
+#include <pebble.h>
+
+#include "vibration_types.h"
+
+Layer *status_layer_create(GRect frame);
+void status_layer_destroy(Layer *layer);
+
+// Show the type's label, or nothing for VibrationTypeCount
+void status_layer_set_type(Layer *layer, VibrationType type);
@@ -0,0 +1,99 @@
+/**
+ * stress.c - Drives the lifecycle stress cycles from an app_timer
+ */
+
+#include "stress.h"
+
+#if STRESS_LIFECYCLE
+
+#define STEP_MS 100
+
+typedef enum {
+  StressStepOpenMenu,
+  StressStepCloseMenu,
+  StressStepUnloadWindow,
+  StressStepReloadWindow,
+
+  StressStepCount
+} StressStep;
+
+static Window *s_window, *s_placeholder_window;
+static StressOpenHandler s_open_handler;
+static StressCloseHandler s_close_handler;
+static StressStep s_step;
+static int s_cycle;
+static size_t s_baseline;
+static int s_leaking_cycles;
+static int s_failed_opens;
+
+static void finish() {
+  // Leave the stack as it was found
+  window_stack_remove(s_placeholder_window, false);
+  window_destroy(s_placeholder_window);
+  s_placeholder_window = NULL;
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "stress: %d cycles, %d with heap drift, %d failed opens, final delta=%d",
+          s_cycle, s_leaking_cycles, s_failed_opens, (int)heap_bytes_used() - (int)s_baseline);
+}
+
+static void check_cycle() {
+  // The first cycle warms up anything allocated once, such as fonts
+  const size_t used = heap_bytes_used();
+  if(s_cycle == 0) {
+    s_baseline = used;
+  } else if(used != s_baseline) {
+    s_leaking_cycles++;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "stress: cycle %d heap drift %d", s_cycle, (int)used - (int)s_baseline);
+  }
+  s_cycle++;
+}
+
+static void open_menu() {
+  // Closing a menu that never opened does nothing, so the cycle carries on
+  if(!s_open_handler()) {
+    s_failed_opens++;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "stress: cycle %d failed to open, %u bytes free", s_cycle,
+            (unsigned)heap_bytes_free());
+  }
+}
+
+static void step_timer_callback(void *context) {
+  switch(s_step) {
+    case StressStepOpenMenu:     open_menu();                              break;
+    case StressStepCloseMenu:    s_close_handler();                        break;
+    case StressStepUnloadWindow: window_stack_remove(s_window, false);     break;
+    case StressStepReloadWindow:
+      window_stack_push(s_window, false);
+      check_cycle();
+      break;
+    default: break;
+  }
+
+  s_step = (s_step + 1) % StressStepCount;
+  if(s_step == StressStepOpenMenu && s_cycle == STRESS_LIFECYCLE_CYCLES) {
+    finish();
+  } else {
+    app_timer_register(STEP_MS, step_timer_callback, NULL);
+  }
+}
+
+void stress_lifecycle_start(Window *window, StressOpenHandler open_handler,
+                            StressCloseHandler close_handler) {
+  s_window = window;
+  s_open_handler = open_handler;
+  s_close_handler = close_handler;
+  s_step = StressStepOpenMenu;
+  s_cycle = 0;
+  s_leaking_cycles = 0;
+  s_failed_opens = 0;
+
+  // Keep a Window underneath so removing the main one doesn't exit the app
+  s_placeholder_window = window_create();
+  window_stack_push(s_placeholder_window, false);
+  window_stack_remove(s_window, false);
+  window_stack_push(s_window, false);
+
+  app_timer_register(STEP_MS, step_timer_callback, NULL);
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+/**
+ * stress.h - Optional lifecycle stress mode, enabled with STRESS_LIFECYCLE in
+ * config.h. Each cycle opens and closes the ActionMenu, then removes and
+ * pushes the main Window again so it is unloaded and reloaded. Heap usage is
+ * compared against the first cycle after every iteration.
+ */
+
+#include <pebble.h>
+
+#include "config.h"
+
+// Returns false if the menu couldn't be opened
+typedef bool (*StressOpenHandler)(void);
+typedef void (*StressCloseHandler)(void);
+
+#if STRESS_LIFECYCLE
+
+#define STRESS_LIFECYCLE_START(window, open, close) stress_lifecycle_start(window, open, close)
+
+void stress_lifecycle_start(Window *window, StressOpenHandler open_handler, StressCloseHandler close_handler);
+
+#else
+
+#define STRESS_LIFECYCLE_START(window, open, close)
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+/**
+ * time_util.h - Millisecond wall clock shared by the instrumentation modes
+ */
+
+#include <pebble.h>
+
+// Milliseconds since the epoch, for measuring intervals between two calls
+static inline uint64_t time_util_now_ms(void) {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  return (uint64_t)seconds * 1000 + ms;
+}
@@ -0,0 +1,72 @@
+/**
+ * trace.c - Ring buffer of timestamped events, with the spans of the latest
+ * click to vibe chain logged as it completes
+ */
+
+#include "trace.h"
+
+#include "time_util.h"
+
+#if TRACE_LATENCY
+
+typedef struct {
+  uint32_t ms;                 // Since the first event
+  uint8_t event;
+} TraceEntry;
+
+static const char *const s_event_names[TraceEventCount] = {
+  [TraceEventClick] = "click",
+  [TraceEventMenuOpen] = "open",
+  [TraceEventAction] = "action",
+  [TraceEventVibe] = "vibe",
+};
+
+static TraceEntry s_entries[TRACE_LATENCY_EVENTS];
+static uint32_t s_num_entries;     // Total recorded, the buffer holds the latest
+static uint64_t s_base_ms;
+
+// Latest time of each event, 0 once consumed by a vibe
+static uint32_t s_last_ms[TraceEventCount];
+
+static void log_chain(uint32_t vibe_ms) {
+  // A long press vibes straight from the click, without a menu in between
+  const uint32_t click_ms = s_last_ms[TraceEventClick];
+  const uint32_t action_ms = s_last_ms[TraceEventAction];
+  if(!click_ms) {
+    return;
+  }
+  if(action_ms >= click_ms) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "trace: click to action %ums, action to vibe %ums, total %ums",
+            (unsigned)(action_ms - click_ms), (unsigned)(vibe_ms - action_ms), (unsigned)(vibe_ms - click_ms));
+  } else {
+    APP_LOG(APP_LOG_LEVEL_INFO, "trace: click to vibe %ums", (unsigned)(vibe_ms - click_ms));
+  }
+}
+
+void trace_event(TraceEvent event) {
+  const uint64_t now = time_util_now_ms();
+  if(s_num_entries == 0) {
+    // Start one ms in, so 0 can mean no event yet
+    s_base_ms = now - 1;
+  }
+  const uint32_t ms = now - s_base_ms;
+
+  s_entries[s_num_entries++ % TRACE_LATENCY_EVENTS] = (TraceEntry) { .ms = ms, .event = event };
+  s_last_ms[event] = ms;
+  if(event == TraceEventVibe) {
+    log_chain(ms);
+    memset(s_last_ms, 0, sizeof(s_last_ms));
+  }
+}
+
+void trace_dump() {
+  const uint32_t first = (s_num_entries > TRACE_LATENCY_EVENTS) ? s_num_entries - TRACE_LATENCY_EVENTS : 0;
+  APP_LOG(APP_LOG_LEVEL_INFO, "trace: %u events, last %u", (unsigned)s_num_entries,
+          (unsigned)(s_num_entries - first));
+  for(uint32_t i = first; i < s_num_entries; i++) {
+    const TraceEntry *entry = &s_entries[i % TRACE_LATENCY_EVENTS];
+    APP_LOG(APP_LOG_LEVEL_INFO, "trace: %6ums %s", (unsigned)entry->ms, s_event_names[entry->event]);
+  }
+}
+
+#endif
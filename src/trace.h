@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * trace.h - Optional click to vibe latency tracing, enabled with
+ * TRACE_LATENCY in config.h. Events are timestamped into a fixed ring buffer
+ * in RAM, each vibe logs how long it took since the click that led to it,
+ * and the whole buffer can be dumped to the app log on demand.
+ */
+
+#include <pebble.h>
+
+#include "config.h"
+
+typedef enum {
+  TraceEventClick,             // Button handler for SELECT
+  TraceEventMenuOpen,          // ActionMenu built and opened
+  TraceEventAction,            // ActionMenu's action callback
+  TraceEventVibe,              // vibes_* called
+  TraceEventCount
+} TraceEvent;
+
+#if TRACE_LATENCY
+
+#define TRACE_EVENT(event) trace_event(event)
+#define TRACE_DUMP() trace_dump()
+
+void trace_event(TraceEvent event);
+
+// Log every event still in the buffer, oldest first
+void trace_dump(void);
+
+#else
+
+#define TRACE_EVENT(event)
+#define TRACE_DUMP()
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * vibe_worker.c - Queues messages until a freshly launched worker reports
+ * that it is ready for them, and plays jobs due together one at a time
+ */
+
+#include "vibe_worker.h"
+
+#include "persist_keys.h"
+#include "worker_protocol.h"
+
+// Messages held while the worker starts up
+#define QUEUE_SIZE 4
+
+// Pause between jobs played one after another, so each can be told apart
+#define PLAY_GAP_MS 500
+
+typedef struct {
+  uint8_t type;
+  AppWorkerMessage message;
+} QueuedMessage;
+
+static VibeWorkerPlayHandler s_play_handler;
+static QueuedMessage s_queue[QUEUE_SIZE];
+static int s_queue_length;
+static bool s_worker_ready;
+
+// Jobs waiting for the one playing to finish
+static VibrationType s_play_queue[WORKER_MAX_JOBS];
+static int s_play_queue_length;
+static AppTimer *s_play_timer;
+
+static void send_message(uint8_t type, AppWorkerMessage message) {
+  if(s_worker_ready) {
+    app_worker_send_message(type, &message);
+    return;
+  }
+
+  // Keep the latest if the worker is slow to start
+  if(s_queue_length == QUEUE_SIZE) {
+    memmove(&s_queue[0], &s_queue[1], (QUEUE_SIZE - 1) * sizeof(s_queue[0]));
+    s_queue_length--;
+  }
+  s_queue[s_queue_length++] = (QueuedMessage) { .type = type, .message = message };
+  if(!app_worker_is_running()) {
+    app_worker_launch();
+  }
+}
+
+static void play_next(void *context) {
+  s_play_timer = NULL;
+  if(s_play_queue_length == 0) {
+    return;
+  }
+
+  // The timer runs until this one has finished, whether or not more follow
+  const VibrationType type = s_play_queue[0];
+  s_play_queue_length--;
+  memmove(&s_play_queue[0], &s_play_queue[1], s_play_queue_length * sizeof(s_play_queue[0]));
+  const uint32_t duration_ms = s_play_handler(type);
+  s_play_timer = app_timer_register(duration_ms + PLAY_GAP_MS, play_next, NULL);
+}
+
+static void play(int32_t type) {
+  if(type < 0 || type >= VibrationTypeCount || s_play_queue_length == WORKER_MAX_JOBS) {
+    return;
+  }
+  s_play_queue[s_play_queue_length++] = (VibrationType)type;
+  if(!s_play_timer) {
+    play_next(NULL);
+  }
+}
+
+static void worker_ready() {
+  s_worker_ready = true;
+  send_message(WorkerMessageAttach, (AppWorkerMessage) { 0 });
+  for(int i = 0; i < s_queue_length; i++) {
+    app_worker_send_message(s_queue[i].type, &s_queue[i].message);
+  }
+  s_queue_length = 0;
+}
+
+static void message_handler(uint16_t type, AppWorkerMessage *message) {
+  switch(type) {
+    case WorkerMessageReady:
+      worker_ready();
+      break;
+    case WorkerMessagePlay:
+      play(message->data0);
+      break;
+  }
+}
+
+bool vibe_worker_init(VibeWorkerPlayHandler play_handler) {
+  s_play_handler = play_handler;
+  app_worker_message_subscribe(message_handler);
+  if(app_worker_is_running()) {
+    worker_ready();
+  }
+
+  // The worker leaves jobs here when it had to launch the app to play them
+  if(!persist_exists(PersistKeyWorkerPendingTypes)) {
+    return false;
+  }
+  uint8_t types[WORKER_MAX_JOBS];
+  const int num_types = persist_read_data(PersistKeyWorkerPendingTypes, types, sizeof(types));
+  persist_delete(PersistKeyWorkerPendingTypes);
+  for(int i = 0; i < num_types; i++) {
+    play(types[i]);
+  }
+  return launch_reason() == APP_LAUNCH_WORKER;
+}
+
+void vibe_worker_deinit() {
+  if(s_play_timer) {
+    app_timer_cancel(s_play_timer);
+    s_play_timer = NULL;
+  }
+  s_play_queue_length = 0;
+
+  // The worker plays jobs by launching the app from here on
+  if(s_worker_ready) {
+    send_message(WorkerMessageDetach, (AppWorkerMessage) { 0 });
+  }
+  app_worker_message_unsubscribe();
+}
+
+bool vibe_worker_is_playing() {
+  return s_play_timer != NULL;
+}
+
+void vibe_worker_repeat(VibrationType type, uint16_t interval_s, uint16_t count) {
+  send_message(WorkerMessageSchedule, (AppWorkerMessage) {
+    .data0 = type,
+    .data1 = interval_s,
+    .data2 = count,
+  });
+}
+
+void vibe_worker_cancel_all() {
+  if(app_worker_is_running()) {
+    app_worker_kill();
+  }
+  s_worker_ready = false;
+  s_queue_length = 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * vibe_worker.h - App side of the background worker. Jobs handed to the
+ * worker keep repeating after the app closes, and come back to the play
+ * handler to be played while the app is open.
+ */
+
+#include <pebble.h>
+
+#include "vibration_types.h"
+
+// Returns how long the vibration lasts, jobs due together play one after another
+typedef uint32_t (*VibeWorkerPlayHandler)(VibrationType type);
+
+// Attach to the worker if it is running, and play anything it left pending.
+// Returns true if the app was launched only to play pending jobs.
+bool vibe_worker_init(VibeWorkerPlayHandler play_handler);
+void vibe_worker_deinit(void);
+
+// Whether jobs due together are still being played
+bool vibe_worker_is_playing(void);
+
+// Play the type every interval_s seconds, count times or forever if 0, so a
+// count of 1 plays it once after the interval. Starts the worker if needed.
+void vibe_worker_repeat(VibrationType type, uint16_t interval_s, uint16_t count);
+
+// Stop every job and the worker with them
+void vibe_worker_cancel_all(void);
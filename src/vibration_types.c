@@ -0,0 +1,17 @@
+/**
+ * vibration_types.c - The one copy of the default labels
+ */
+
+#include "vibration_types.h"
+
+#include <stddef.h>
+
+#define VIBRATION_TYPE_LABEL(name, label, play, on_ms, off_ms, repeat) [VibrationType##name] = label,
+
+static const char *const s_labels[VibrationTypeCount] = {
+  VIBRATION_TYPES(VIBRATION_TYPE_LABEL)
+};
+
+const char *vibration_type_get_label(VibrationType type) {
+  return (type < VibrationTypeCount) ? s_labels[type] : NULL;
+}
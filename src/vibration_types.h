@@ -0,0 +1,31 @@
+#pragma once
+
+/**
+ * vibration_types.h - The single list of vibration types. The VibrationType
+ * enum, the default labels and the pattern table are all generated from it,
+ * and tools/pack_menu.py reads it to number the types in the MENU resource
+ * and, through tools/gen_js_names.py, in the phone's definitions.
+ *
+ * Columns: name, label, system pattern (or NULL), on ms, off ms, repeat. For
+ * system patterns the timings approximate them, and are used to estimate
+ * their cost or when they have to be scaled down.
+ */
+
+#define VIBRATION_TYPES(X) \
+  X(Short,        "Short",         vibes_short_pulse,  250, 0,   1) \
+  X(Long,         "Long",          vibes_long_pulse,   500, 0,   1) \
+  X(Double,       "Double",        vibes_double_pulse, 100, 100, 2) \
+  X(CustomShort,  "Custom Fast",   NULL,               100, 100, 3) \
+  X(CustomMedium, "Custom Medium", NULL,               200, 200, 3) \
+  X(CustomLong,   "Custom Slow",   NULL,               300, 300, 3)
+
+#define VIBRATION_TYPE_ENUM(name, label, play, on_ms, off_ms, repeat) VibrationType##name,
+
+typedef enum {
+  VIBRATION_TYPES(VIBRATION_TYPE_ENUM)
+
+  VibrationTypeCount
+} VibrationType;
+
+// Default label, used wherever a type is shown without one of its own
+const char *vibration_type_get_label(VibrationType type);
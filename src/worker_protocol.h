@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * worker_protocol.h - Messages between the app and the background worker in
+ * worker_src/. Workers can't drive the vibe motor, so the worker only keeps
+ * time and asks the app to play each job as it comes due.
+ */
+
+// Most jobs the worker holds at once, scheduling more replaces the oldest
+#define WORKER_MAX_JOBS 8
+
+// Shortest interval kept once the app closes. Each job played then launches
+// the app for a few seconds, which more often would take over the watch.
+#define WORKER_MIN_DETACHED_INTERVAL_S 60
+
+typedef enum {
+  // App to worker. Attach and Detach say whether the app can play jobs itself
+  WorkerMessageAttach,
+  WorkerMessageDetach,
+  WorkerMessageSchedule,       // data0 type, data1 interval s, data2 count or 0 for forever
+
+  // Worker to app
+  WorkerMessageReady,          // Sent once at startup, queued messages can follow
+  WorkerMessagePlay,           // data0 type
+} WorkerMessage;
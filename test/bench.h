@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * bench.h - Timing loop for the host benchmarks. Each run is repeated until
+ * it has taken long enough for the clock to be meaningful.
+ */
+
+#include <time.h>
+
+#define BENCH_MIN_RUN_NS 200000000LL
+
+static long long bench_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Mean time of one call to run, in ns
+static double bench_run(void (*run)(void)) {
+  long long iterations = 0;
+  const long long start = bench_now_ns();
+  long long elapsed;
+  do {
+    run();
+    iterations++;
+    elapsed = bench_now_ns() - start;
+  } while(elapsed < BENCH_MIN_RUN_NS);
+  return (double)elapsed / iterations;
+}
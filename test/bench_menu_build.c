@@ -0,0 +1,82 @@
+/**
+ * bench_menu_build.c - Times sizing and building the root frame of
+ * definitions of 10, 100 and 1000 actions, nested, flattened and with cost
+ * labels, against the mock levels
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "menu_build.h"
+#include "menu_data.h"
+#include "menu_gen.h"
+#include "mock_levels.h"
+
+#define MAX_SIZE 32768
+
+static uint8_t s_data[MAX_SIZE];
+static uint16_t s_usage_counts[VibrationTypeCount];
+static uint16_t s_costs[VibrationTypeCount];
+static MenuBuild s_build = {
+  .data = s_data,
+  .usage_counts = s_usage_counts,
+  .builder = &mock_levels_builder,
+};
+static int s_root;
+static volatile size_t s_sink;
+
+static void run_arena_size() {
+  s_sink += menu_build_frame_arena_size(&s_build, s_root);
+}
+
+static void run_build() {
+  // As opening the frame does: size the arena, build, then release it all
+  Arena arena;
+  if(!arena_init(&arena, menu_build_frame_arena_size(&s_build, s_root))) {
+    return;
+  }
+  void *root = menu_build_level(&s_build, &arena, s_root, 0, true);
+  if(root) {
+    s_build.builder->destroy_level(root);
+    s_sink++;
+  }
+  arena_release(&arena);
+}
+
+static void bench(const char *name, void (*run)(void), int num_actions, bool flatten, bool costs) {
+  s_build.flatten = flatten;
+  s_build.costs = costs ? s_costs : NULL;
+  mock_level_stats = (MockLevelStats) { 0 };
+  const double ns = bench_run(run);
+  printf("%-12s %5d actions %12.0f ns\n", name, num_actions, ns);
+}
+
+int main() {
+  // Rank later types higher, so every level is reordered
+  for(int i = 0; i < VibrationTypeCount; i++) {
+    s_usage_counts[i] = i;
+    s_costs[i] = 100 * (i + 1);
+  }
+
+  static const int sizes[] = { 10, 100, 1000 };
+  for(unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    s_build.size = menu_gen_definition(s_data, MAX_SIZE, sizes[i], VibrationTypeCount);
+    if(s_build.size == 0) {
+      printf("%d actions don't fit\n", sizes[i]);
+      return 1;
+    }
+    s_root = menu_data_num_levels(s_data, s_build.size) - 1;
+
+    bench("arena_size", run_arena_size, sizes[i], false, false);
+    bench("build", run_build, sizes[i], false, false);
+    bench("build_flat", run_build, sizes[i], true, false);
+    bench("build_costs", run_build, sizes[i], false, true);
+    if(mock_level_stats.capacity_errors || mock_level_stats.abandoned) {
+      printf("%d actions built with errors\n", sizes[i]);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * bench_menu_data.c - Times generating, indexing, finding every record of,
+ * validating and hashing definitions of 10, 100 and 1000 actions
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "menu_commands.h"
+#include "menu_data.h"
+#include "menu_gen.h"
+#include "vibration_types.h"
+
+#define MAX_SIZE 32768
+
+static uint8_t s_data[MAX_SIZE];
+static size_t s_size;
+static int s_num_actions;
+static volatile uint32_t s_sink;
+
+static void run_generate() {
+  s_size = menu_gen_definition(s_data, MAX_SIZE, s_num_actions, VibrationTypeCount);
+}
+
+static void run_index() {
+  MenuRecord records[MENU_MAX_LEVELS];
+  s_sink += menu_data_index(s_data, s_size, records, MENU_MAX_LEVELS);
+}
+
+static void run_find_all() {
+  // As building each level does, from the root down
+  const int num_levels = menu_data_num_levels(s_data, s_size);
+  for(int l = num_levels - 1; l >= 0; l--) {
+    size_t length;
+    s_sink += (uintptr_t)menu_data_find_record(s_data, s_size, l, &length);
+  }
+}
+
+static void run_validate() {
+  s_sink += menu_data_validate(s_data, s_size, VibrationTypeCount, MenuCommandCount, MENU_MAX_DEPTH);
+}
+
+static void run_hash() {
+  s_sink += menu_data_hash(s_data, s_size, MENU_DATA_HASH_SEED);
+}
+
+static void bench(const char *name, void (*run)(void), int num_actions) {
+  s_num_actions = num_actions;
+  const double ns = bench_run(run);
+  printf("%-10s %5d actions %6zu bytes %12.0f ns\n", name, num_actions, s_size, ns);
+}
+
+int main() {
+  static const int sizes[] = { 10, 100, 1000 };
+  for(unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench("generate", run_generate, sizes[i]);
+    if(s_size == 0) {
+      printf("%d actions don't fit\n", sizes[i]);
+      return 1;
+    }
+    bench("index", run_index, sizes[i]);
+    bench("find_all", run_find_all, sizes[i]);
+    bench("validate", run_validate, sizes[i]);
+    bench("hash", run_hash, sizes[i]);
+  }
+  return 0;
+}
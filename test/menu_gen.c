@@ -0,0 +1,64 @@
+/**
+ * menu_gen.c - Test definitions laid out as tools/pack_menu.py writes them,
+ * children before their parents and the root last
+ */
+
+#include "menu_gen.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "menu_data.h"
+
+static size_t write_item(uint8_t *data, size_t offset, size_t max_size, uint8_t kind, uint8_t value,
+                         const char *label) {
+  const size_t label_length = strlen(label) + 1;
+  if(offset + MENU_ITEM_HEADER_SIZE + label_length > max_size) {
+    return 0;
+  }
+  data[offset] = kind;
+  data[offset + 1] = value;
+  data[offset + 2] = label_length;
+  memcpy(&data[offset + MENU_ITEM_HEADER_SIZE], label, label_length);
+  return offset + MENU_ITEM_HEADER_SIZE + label_length;
+}
+
+size_t menu_gen_definition(uint8_t *data, size_t max_size, int num_actions, int num_types) {
+  const int num_leaves = (num_actions + MENU_GEN_WIDTH - 1) / MENU_GEN_WIDTH;
+  if(num_leaves + 1 > MENU_MAX_LEVELS || num_leaves > UINT8_MAX || max_size < MENU_HEADER_SIZE) {
+    return 0;
+  }
+
+  size_t offset = MENU_HEADER_SIZE;
+  char label[16];
+  for(int l = 0; l < num_leaves; l++) {
+    const int first = l * MENU_GEN_WIDTH;
+    const int num_items = (num_actions - first < MENU_GEN_WIDTH) ? num_actions - first : MENU_GEN_WIDTH;
+    if(offset >= max_size) {
+      return 0;
+    }
+    data[offset++] = num_items;
+    for(int i = 0; i < num_items; i++) {
+      snprintf(label, sizeof(label), "Item %d", first + i);
+      offset = write_item(data, offset, max_size, MenuItemKindAction, (first + i) % num_types, label);
+      if(offset == 0) {
+        return 0;
+      }
+    }
+  }
+
+  if(offset >= max_size) {
+    return 0;
+  }
+  data[offset++] = num_leaves;
+  for(int l = 0; l < num_leaves; l++) {
+    snprintf(label, sizeof(label), "Level %d", l);
+    offset = write_item(data, offset, max_size, MenuItemKindChild, l, label);
+    if(offset == 0) {
+      return 0;
+    }
+  }
+
+  menu_data_write_header(data, num_leaves + 1);
+  return offset;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+ * menu_gen.h - Generates packed menu definitions of a given number of
+ * actions, spread over leaf levels of MENU_GEN_WIDTH under one root
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MENU_GEN_WIDTH 8
+
+// Returns the definition's size, or 0 if it doesn't fit in max_size
+size_t menu_gen_definition(uint8_t *data, size_t max_size, int num_actions, int num_types);
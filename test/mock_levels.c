@@ -0,0 +1,99 @@
+/**
+ * mock_levels.c - Heap backed levels for the host builds of menu_build.c
+ */
+
+#include "mock_levels.h"
+
+#include <stdlib.h>
+
+MockLevelStats mock_level_stats;
+
+static int s_creates_left = -1;
+
+static void *create_level(int capacity) {
+  if(s_creates_left == 0) {
+    return NULL;
+  }
+  if(s_creates_left > 0) {
+    s_creates_left--;
+  }
+
+  MockLevel *level = calloc(1, sizeof(MockLevel));
+  if(!level) {
+    return NULL;
+  }
+  level->capacity = capacity;
+  level->labels = calloc(capacity + 1, sizeof(*level->labels));
+  level->kinds = calloc(capacity + 1, sizeof(*level->kinds));
+  level->values = calloc(capacity + 1, sizeof(*level->values));
+  level->children = calloc(capacity + 1, sizeof(*level->children));
+  mock_level_stats.alive++;
+  return level;
+}
+
+static MockLevel *add_item(MockLevel *level, const char *label) {
+  // Like action_menu_level_add_action(), an add to a full level is refused
+  if(level->num_items == level->capacity) {
+    return NULL;
+  }
+  level->labels[level->num_items] = label;
+  return level;
+}
+
+static bool add_action(void *level, const char *label, uint8_t kind, uint8_t value) {
+  MockLevel *mock = add_item(level, label);
+  if(!mock) {
+    return false;
+  }
+  mock->kinds[mock->num_items] = kind;
+  mock->values[mock->num_items] = value;
+  mock->num_items++;
+  return true;
+}
+
+static bool add_child(void *level, void *child, const char *label) {
+  MockLevel *mock = add_item(level, label);
+  if(!mock) {
+    return false;
+  }
+  mock->children[mock->num_items++] = child;
+  return true;
+}
+
+static void destroy_level(void *level) {
+  // Takes its children with it, as action_menu_hierarchy_destroy() does
+  MockLevel *mock = level;
+  for(int i = 0; i < mock->num_items; i++) {
+    if(mock->children[i]) {
+      destroy_level(mock->children[i]);
+    }
+  }
+  free(mock->labels);
+  free(mock->kinds);
+  free(mock->values);
+  free(mock->children);
+  free(mock);
+  mock_level_stats.alive--;
+}
+
+static void level_built(int capacity, int num_added, bool valid) {
+  mock_level_stats.built++;
+  if(!valid) {
+    mock_level_stats.abandoned++;
+  }
+  if(valid ? (num_added != capacity) : (num_added == capacity)) {
+    mock_level_stats.capacity_errors++;
+  }
+}
+
+const MenuBuilder mock_levels_builder = {
+  .create_level = create_level,
+  .add_action = add_action,
+  .add_child = add_child,
+  .destroy_level = destroy_level,
+  .level_built = level_built,
+};
+
+void mock_levels_fail_after(int num_creates) {
+  s_creates_left = num_creates;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * mock_levels.h - Stands in for the ActionMenuLevel calls behind a
+ * MenuBuilder, enforcing each level's capacity as the firmware does and
+ * counting what is still alive
+ */
+
+#include "menu_build.h"
+
+typedef struct MockLevel {
+  int capacity;
+  int num_items;
+  const char **labels;
+  uint8_t *kinds;
+  uint8_t *values;
+  // Children of inline items, NULL for actions and portals
+  struct MockLevel **children;
+} MockLevel;
+
+typedef struct {
+  int alive;
+  int built;
+  int abandoned;
+  // Levels left with room over, or refused an add once full
+  int capacity_errors;
+} MockLevelStats;
+
+extern const MenuBuilder mock_levels_builder;
+extern MockLevelStats mock_level_stats;
+
+// Fail every create_level from the given count on, -1 never fails
+void mock_levels_fail_after(int num_creates);
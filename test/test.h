@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+ * test.h - Minimal checks for the host tests. Each test file builds into its
+ * own program, which exits non-zero if any check failed.
+ */
+
+#include <stdio.h>
+
+static int s_failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      s_failures++; \
+    } \
+  } while(0)
+
+#define TEST_RESULT() (printf("%s: %s\n", __FILE__, s_failures ? "FAILED" : "ok"), s_failures ? 1 : 0)
@@ -0,0 +1,104 @@
+/**
+ * test_composer.c - Composed patterns stay within their segment and duration
+ * budget, and refused edits leave the pattern untouched
+ */
+
+#include <string.h>
+
+#include "composer.h"
+#include "test.h"
+
+static void test_empty() {
+  Composer composer;
+  composer_clear(&composer);
+
+  const uint32_t *segments;
+  uint32_t num_segments;
+  CHECK(composer_get_pattern(&composer, &segments, &num_segments) == ComposerResultEmpty);
+  CHECK(composer_add_gap(&composer) == ComposerResultEmpty);
+  CHECK(composer_repeat(&composer) == ComposerResultEmpty);
+}
+
+static void test_merging() {
+  Composer composer;
+  composer_clear(&composer);
+  CHECK(composer_add_pulse(&composer) == ComposerResultOk);
+  CHECK(composer_add_pulse(&composer) == ComposerResultOk);
+  CHECK(composer_add_gap(&composer) == ComposerResultOk);
+  CHECK(composer.num_segments == 2);
+  CHECK(composer.segments[0] == 2 * COMPOSER_STEP_MS);
+  CHECK(composer.total_ms == 3 * COMPOSER_STEP_MS);
+
+  // The trailing gap is left out of what gets played
+  const uint32_t *segments;
+  uint32_t num_segments;
+  CHECK(composer_get_pattern(&composer, &segments, &num_segments) == ComposerResultOk);
+  CHECK(num_segments == 1);
+}
+
+static void test_repeat() {
+  Composer composer;
+  composer_clear(&composer);
+  composer_add_pulse(&composer);
+  CHECK(composer_repeat(&composer) == ComposerResultOk);
+  CHECK(composer.num_segments == 3);
+  CHECK(composer.segments[1] == COMPOSER_STEP_MS);
+  CHECK(composer.total_ms == 3 * COMPOSER_STEP_MS);
+}
+
+static void test_segment_budget() {
+  // Alternating primitives use a segment each, until the budget runs out
+  Composer composer;
+  composer_clear(&composer);
+  for(int i = 0; i < COMPOSER_MAX_SEGMENTS; i++) {
+    CHECK(((i % 2) ? composer_add_gap(&composer) : composer_add_pulse(&composer)) == ComposerResultOk);
+  }
+  const Composer full = composer;
+  CHECK(composer_add_pulse(&composer) == ComposerResultTooManySegments);
+  CHECK(composer_repeat(&composer) == ComposerResultTooManySegments);
+  CHECK(memcmp(&composer, &full, sizeof(Composer)) == 0);
+
+  // Lengthening the last segment needs no new one
+  CHECK(composer_add_gap(&composer) == ComposerResultOk);
+}
+
+static void test_duration_budget() {
+  Composer composer;
+  composer_clear(&composer);
+  for(int i = 0; i < COMPOSER_MAX_DURATION_MS / COMPOSER_STEP_MS; i++) {
+    CHECK(composer_add_pulse(&composer) == ComposerResultOk);
+  }
+  const Composer full = composer;
+  CHECK(composer_add_pulse(&composer) == ComposerResultTooLong);
+  CHECK(composer_add_gap(&composer) == ComposerResultTooLong);
+  CHECK(composer_repeat(&composer) == ComposerResultTooLong);
+  CHECK(memcmp(&composer, &full, sizeof(Composer)) == 0);
+
+  const uint32_t *segments;
+  uint32_t num_segments;
+  CHECK(composer_get_pattern(&composer, &segments, &num_segments) == ComposerResultOk);
+  CHECK(num_segments == 1 && segments[0] == COMPOSER_MAX_DURATION_MS);
+}
+
+static void test_repeat_until_full() {
+  // Every accepted repeat keeps within both budgets
+  Composer composer;
+  composer_clear(&composer);
+  composer_add_pulse(&composer);
+  composer_add_gap(&composer);
+  while(composer_repeat(&composer) == ComposerResultOk) {
+    CHECK(composer.num_segments <= COMPOSER_MAX_SEGMENTS);
+    CHECK(composer.total_ms <= COMPOSER_MAX_DURATION_MS);
+  }
+  CHECK(composer.num_segments == COMPOSER_MAX_SEGMENTS);
+}
+
+int main() {
+  test_empty();
+  test_merging();
+  test_repeat();
+  test_segment_budget();
+  test_duration_budget();
+  test_repeat_until_full();
+  return TEST_RESULT();
+}
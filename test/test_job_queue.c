@@ -0,0 +1,100 @@
+/**
+ * test_job_queue.c - Due times, coalescing and repeat counts of worker jobs
+ */
+
+#include "job_queue.h"
+#include "test.h"
+
+static void test_single() {
+  JobQueue queue;
+  job_queue_clear(&queue);
+  time_t fire_at;
+  CHECK(!job_queue_next_fire(&queue, &fire_at));
+
+  // Twice then done, allowed to run a quarter of its interval late
+  job_queue_add(&queue, 1, 40, 2, 1000);
+  CHECK(job_queue_next_fire(&queue, &fire_at) && fire_at == 1050);
+
+  uint16_t type;
+  CHECK(job_queue_take_due(&queue, 1039, &type) == 0);
+  CHECK(job_queue_take_due(&queue, 1050, &type) == 1 && type == 1);
+  CHECK(job_queue_next_fire(&queue, &fire_at) && fire_at == 1090);
+  CHECK(job_queue_take_due(&queue, 1090, &type) == 1);
+  CHECK(queue.num_jobs == 0);
+}
+
+static void test_lateness_cap() {
+  JobQueue queue;
+  job_queue_clear(&queue);
+  job_queue_add(&queue, 1, 600, 0, 0);
+  time_t fire_at;
+  CHECK(job_queue_next_fire(&queue, &fire_at) && fire_at == 600 + JOB_QUEUE_MAX_LATENESS_S);
+}
+
+static void test_replace() {
+  // A type has one job, and the oldest makes way once the queue is full
+  JobQueue queue;
+  job_queue_clear(&queue);
+  job_queue_add(&queue, 1, 10, 0, 0);
+  job_queue_add(&queue, 1, 20, 0, 0);
+  CHECK(queue.num_jobs == 1 && queue.jobs[0].interval_s == 20);
+
+  for(int t = 2; t <= WORKER_MAX_JOBS + 1; t++) {
+    job_queue_add(&queue, t, 100 + t, 0, 0);
+  }
+  CHECK(queue.num_jobs == WORKER_MAX_JOBS);
+  for(int i = 0; i < queue.num_jobs; i++) {
+    CHECK(queue.jobs[i].type != 1);
+  }
+}
+
+static void test_cadence() {
+  // Running late doesn't shift later runs
+  JobQueue queue;
+  job_queue_clear(&queue);
+  job_queue_add(&queue, 1, 10, 0, 0);
+  uint16_t type;
+  CHECK(job_queue_take_due(&queue, 12, &type) == 1);
+  CHECK(queue.jobs[0].due == 20);
+  CHECK(job_queue_take_due(&queue, 45, &type) == 1);
+  CHECK(queue.jobs[0].due == 50);
+}
+
+static void test_due_together() {
+  // Jobs sharing a wakeup all come back, in the order they fell due
+  JobQueue queue;
+  job_queue_clear(&queue);
+  job_queue_add(&queue, 2, 60, 0, 0);
+  job_queue_add(&queue, 1, 10, 0, 0);
+  job_queue_add(&queue, 3, 55, 0, 0);
+
+  uint16_t types[WORKER_MAX_JOBS];
+  CHECK(job_queue_take_due(&queue, 50, types) == 1 && types[0] == 1);
+  CHECK(job_queue_take_due(&queue, 60, types) == 3);
+  CHECK(types[0] == 3 && types[1] == 2 && types[2] == 1);
+  CHECK(queue.num_jobs == 3);
+}
+
+static void test_remove_shorter() {
+  JobQueue queue;
+  job_queue_clear(&queue);
+  job_queue_add(&queue, 1, 10, 0, 0);
+  job_queue_add(&queue, 2, 60, 0, 0);
+  job_queue_add(&queue, 3, 30, 0, 0);
+  job_queue_add(&queue, 4, 300, 1, 0);
+  job_queue_remove_shorter(&queue, 60);
+  CHECK(queue.num_jobs == 2);
+  for(int i = 0; i < queue.num_jobs; i++) {
+    CHECK(queue.jobs[i].interval_s >= 60);
+  }
+}
+
+int main() {
+  test_single();
+  test_lateness_cap();
+  test_replace();
+  test_cadence();
+  test_due_together();
+  test_remove_shorter();
+  return TEST_RESULT();
+}
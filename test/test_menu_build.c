@@ -0,0 +1,295 @@
+/**
+ * test_menu_build.c - Level capacities, arena sizing and item order of the
+ * frames built from generated and hand written definitions
+ */
+
+#include <string.h>
+
+#include "menu_commands.h"
+#include "menu_data.h"
+#include "menu_gen.h"
+#include "mock_levels.h"
+#include "test.h"
+
+#define MAX_SIZE 16384
+
+static uint8_t s_data[MAX_SIZE];
+static size_t s_size;
+static uint16_t s_costs[VibrationTypeCount];
+
+/******************************** Definitions *********************************/
+
+static void begin_level(int num_items) {
+  if(s_size == 0) {
+    s_size = MENU_HEADER_SIZE;
+  }
+  s_data[s_size++] = num_items;
+}
+
+static void add_item(MenuItemKind kind, uint8_t value, const char *label) {
+  const size_t label_length = label ? strlen(label) + 1 : 0;
+  s_data[s_size++] = kind;
+  s_data[s_size++] = value;
+  s_data[s_size++] = label_length;
+  if(label) {
+    memcpy(&s_data[s_size], label, label_length);
+    s_size += label_length;
+  }
+}
+
+static void write_mixed() {
+  // 0: actions, 1: an action and a command, 2: holds 0, 3: the root
+  s_size = 0;
+  begin_level(3);
+  add_item(MenuItemKindAction, VibrationTypeShort, NULL);
+  add_item(MenuItemKindAction, VibrationTypeLong, NULL);
+  add_item(MenuItemKindAction, VibrationTypeDouble, NULL);
+  begin_level(2);
+  add_item(MenuItemKindAction, VibrationTypeCustomShort, "Fast");
+  add_item(MenuItemKindCommand, MenuCommandStopRepeating, NULL);
+  begin_level(1);
+  add_item(MenuItemKindChild, 0, "Nested");
+  begin_level(4);
+  add_item(MenuItemKindChild, 0, "Actions");
+  add_item(MenuItemKindChild, 1, "Mixed");
+  add_item(MenuItemKindChild, 2, "Deeper");
+  add_item(MenuItemKindAction, VibrationTypeCustomLong, NULL);
+  menu_data_write_header(s_data, 4);
+}
+
+/********************************** Building **********************************/
+
+static MockLevel *build_frame(const MenuBuild *build, int level_index, Arena *arena) {
+  const size_t arena_size = menu_build_frame_arena_size(build, level_index);
+  CHECK(arena_size > 0);
+  CHECK(arena_init(arena, arena_size));
+  return menu_build_level(build, arena, level_index, 0, true);
+}
+
+static void destroy_frame(const MenuBuild *build, MockLevel *root, Arena *arena) {
+  if(root) {
+    build->builder->destroy_level(root);
+  }
+  arena_release(arena);
+  CHECK(mock_level_stats.alive == 0);
+}
+
+static size_t scratch_size(int num_items, bool costs) {
+  return num_items * (sizeof(MenuItem) + (costs ? MENU_COST_LABEL_SIZE : 0)) + sizeof(uintptr_t);
+}
+
+static bool has_cost_label(const char *label) {
+  const size_t length = strlen(label);
+  return length > 4 && strcmp(&label[length - 3], "ms)") == 0;
+}
+
+/*********************************** Tests ************************************/
+
+static void test_generated_capacity() {
+  static const int sizes[] = { 10, 100, 1000 };
+  for(unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    s_size = menu_gen_definition(s_data, MAX_SIZE, sizes[s], VibrationTypeCount);
+    CHECK(s_size > 0);
+    const int num_leaves = menu_data_num_levels(s_data, s_size) - 1;
+
+    for(int flags = 0; flags < 4; flags++) {
+      const bool flatten = flags & 1;
+      const bool costs = flags & 2;
+      const MenuBuild build = {
+        .data = s_data,
+        .size = s_size,
+        .costs = costs ? s_costs : NULL,
+        .flatten = flatten,
+        .builder = &mock_levels_builder,
+      };
+      mock_level_stats = (MockLevelStats) { 0 };
+
+      // Every leaf is shown inline, or spliced into the root when flattened
+      Arena arena;
+      MockLevel *root = build_frame(&build, num_leaves, &arena);
+      CHECK(root != NULL);
+      CHECK(mock_level_stats.capacity_errors == 0);
+      CHECK(mock_level_stats.abandoned == 0);
+      CHECK(mock_level_stats.built == (flatten ? 1 : 1 + num_leaves));
+      CHECK(root && root->capacity == (flatten ? sizes[s] : num_leaves));
+      CHECK(arena.used <= arena.size);
+
+      // Cost labels only fall back to the plain label when the arena runs out
+      const MockLevel *level = (root && !flatten) ? root->children[num_leaves - 1] : root;
+      CHECK(level && level->num_items > 0);
+      for(int i = 0; level && i < level->num_items; i++) {
+        CHECK(has_cost_label(level->labels[i]) == costs);
+      }
+      destroy_frame(&build, root, &arena);
+    }
+  }
+}
+
+static void test_arena_size() {
+  write_mixed();
+  for(int costs = 0; costs < 2; costs++) {
+    const MenuBuild build = {
+      .data = s_data,
+      .size = s_size,
+      .costs = costs ? s_costs : NULL,
+      .builder = &mock_levels_builder,
+    };
+
+    // The root and each of its child levels shown inline, not the portal
+    CHECK(menu_build_frame_arena_size(&build, 3) ==
+          scratch_size(4, costs) + scratch_size(3, costs) + scratch_size(2, costs));
+    CHECK(menu_build_frame_arena_size(&build, 0) == scratch_size(3, costs));
+    CHECK(menu_build_frame_arena_size(&build, 4) == 0);
+  }
+}
+
+static void test_inline_and_flatten() {
+  write_mixed();
+  for(int flatten = 0; flatten < 2; flatten++) {
+    const MenuBuild build = {
+      .data = s_data,
+      .size = s_size,
+      .flatten = flatten,
+      .builder = &mock_levels_builder,
+    };
+    mock_level_stats = (MockLevelStats) { 0 };
+
+    // Only the level of actions is flattened, the one with a command needs its label
+    Arena arena;
+    MockLevel *root = build_frame(&build, 3, &arena);
+    CHECK(root != NULL);
+    CHECK(mock_level_stats.capacity_errors == 0);
+    if(!root) {
+      continue;
+    }
+    CHECK(root->capacity == (flatten ? 6 : 4));
+    CHECK(root->num_items == root->capacity);
+    int num_children = 0, num_portals = 0;
+    for(int i = 0; i < root->num_items; i++) {
+      num_children += root->children[i] != NULL;
+      num_portals += !root->children[i] && root->kinds[i] == MenuItemKindChild;
+      if(root->children[i] == NULL && root->kinds[i] == MenuItemKindChild) {
+        CHECK(strcmp(root->labels[i], "Deeper") == 0);
+        CHECK(root->values[i] == 2);
+      }
+    }
+    CHECK(num_children == (flatten ? 1 : 2));
+    CHECK(num_portals == 1);
+    destroy_frame(&build, root, &arena);
+  }
+}
+
+static void test_wide_child() {
+  // 0: one action too many to show inline, 1: the root
+  s_size = 0;
+  begin_level(MENU_INLINE_MAX_WIDTH + 1);
+  for(int i = 0; i <= MENU_INLINE_MAX_WIDTH; i++) {
+    add_item(MenuItemKindAction, i % VibrationTypeCount, NULL);
+  }
+  begin_level(2);
+  add_item(MenuItemKindChild, 0, "Wide");
+  add_item(MenuItemKindAction, VibrationTypeShort, NULL);
+  menu_data_write_header(s_data, 2);
+
+  for(int flatten = 0; flatten < 2; flatten++) {
+    const MenuBuild build = {
+      .data = s_data,
+      .size = s_size,
+      .flatten = flatten,
+      .builder = &mock_levels_builder,
+    };
+    mock_level_stats = (MockLevelStats) { 0 };
+
+    // Opens as its own frame, flattened or not
+    CHECK(menu_build_frame_arena_size(&build, 1) == scratch_size(2, false));
+    Arena arena;
+    MockLevel *root = build_frame(&build, 1, &arena);
+    CHECK(root && root->capacity == 2);
+    CHECK(root && root->children[0] == NULL && root->kinds[0] == MenuItemKindChild);
+    CHECK(mock_level_stats.built == 1);
+    destroy_frame(&build, root, &arena);
+
+    root = build_frame(&build, 0, &arena);
+    CHECK(root && root->capacity == MENU_INLINE_MAX_WIDTH + 1);
+    CHECK(mock_level_stats.capacity_errors == 0);
+    destroy_frame(&build, root, &arena);
+  }
+}
+
+static void test_order() {
+  write_mixed();
+  uint16_t usage_counts[VibrationTypeCount] = { 0 };
+  usage_counts[VibrationTypeDouble] = 5;
+  usage_counts[VibrationTypeLong] = 2;
+  const VibrationType last_used = VibrationTypeCustomShort;
+  const MenuBuild build = {
+    .data = s_data,
+    .size = s_size,
+    .last_used = &last_used,
+    .usage_counts = usage_counts,
+    .flatten = true,
+    .builder = &mock_levels_builder,
+  };
+
+  // The path to the last used action first, then the most used, then as defined
+  Arena arena;
+  MockLevel *root = build_frame(&build, 3, &arena);
+  CHECK(root && root->num_items == 6);
+  if(root && root->num_items == 6) {
+    CHECK(strcmp(root->labels[0], "Mixed") == 0);
+    CHECK(root->values[1] == VibrationTypeDouble);
+    CHECK(root->values[2] == VibrationTypeLong);
+    CHECK(root->values[3] == VibrationTypeShort);
+    CHECK(strcmp(root->labels[3], vibration_type_get_label(VibrationTypeShort)) == 0);
+    CHECK(strcmp(root->labels[4], "Deeper") == 0);
+    CHECK(root->values[5] == VibrationTypeCustomLong);
+  }
+  destroy_frame(&build, root, &arena);
+}
+
+static void test_failures() {
+  write_mixed();
+  s_costs[VibrationTypeShort] = 250;
+  const MenuBuild build = {
+    .data = s_data,
+    .size = s_size,
+    .costs = s_costs,
+    .builder = &mock_levels_builder,
+  };
+
+  // An arena too small for the inline children abandons the whole frame
+  Arena arena;
+  CHECK(arena_init(&arena, scratch_size(4, false)));
+  mock_level_stats = (MockLevelStats) { 0 };
+  CHECK(menu_build_level(&build, &arena, 3, 0, true) == NULL);
+  destroy_frame(&build, NULL, &arena);
+
+  // As does any level failing to be created
+  for(int creates = 0; creates < 3; creates++) {
+    mock_levels_fail_after(creates);
+    mock_level_stats = (MockLevelStats) { 0 };
+    MockLevel *root = build_frame(&build, 3, &arena);
+    CHECK(root == NULL);
+    CHECK(mock_level_stats.capacity_errors == 0);
+    destroy_frame(&build, root, &arena);
+  }
+  mock_levels_fail_after(-1);
+
+  // Labels carry the motor time of their type
+  MockLevel *root = build_frame(&build, 0, &arena);
+  CHECK(root && strcmp(root->labels[0], "Short (250ms)") == 0);
+  destroy_frame(&build, root, &arena);
+}
+
+int main() {
+  for(int i = 0; i < VibrationTypeCount; i++) {
+    s_costs[i] = 100 * (i + 1);
+  }
+  test_generated_capacity();
+  test_arena_size();
+  test_inline_and_flatten();
+  test_wide_child();
+  test_order();
+  test_failures();
+  return TEST_RESULT();
+}
@@ -0,0 +1,151 @@
+/**
+ * test_menu_data.c - Indexing and finding records in well formed and
+ * malformed definitions
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "menu_commands.h"
+#include "menu_data.h"
+#include "menu_gen.h"
+#include "test.h"
+#include "vibration_types.h"
+
+#define MAX_SIZE 16384
+
+static uint8_t s_data[MAX_SIZE];
+
+static void test_index() {
+  const size_t size = menu_gen_definition(s_data, MAX_SIZE, 100, VibrationTypeCount);
+  CHECK(size > 0);
+
+  const int num_levels = menu_data_num_levels(s_data, size);
+  CHECK(num_levels == 100 / MENU_GEN_WIDTH + 2);
+
+  MenuRecord records[MENU_MAX_LEVELS];
+  CHECK(menu_data_index(s_data, size, records, MENU_MAX_LEVELS) == num_levels);
+  CHECK(records[0].offset == MENU_HEADER_SIZE);
+  CHECK(records[num_levels - 1].offset + records[num_levels - 1].length == size);
+
+  // Finding a record agrees with the index
+  for(int l = 0; l < num_levels; l++) {
+    size_t length;
+    const uint8_t *record = menu_data_find_record(s_data, size, l, &length);
+    CHECK(record == s_data + records[l].offset);
+    CHECK(length == records[l].length);
+  }
+
+  size_t length;
+  CHECK(menu_data_find_record(s_data, size, num_levels, &length) == NULL);
+  CHECK(menu_data_find_record(s_data, size, -1, &length) == NULL);
+  CHECK(menu_data_index(s_data, size, records, num_levels - 1) == 0);
+}
+
+static void test_malformed() {
+  const size_t size = menu_gen_definition(s_data, MAX_SIZE, 10, VibrationTypeCount);
+  MenuRecord records[MENU_MAX_LEVELS];
+
+  // Any truncation leaves a record running past the end
+  for(size_t cut = 0; cut < size; cut++) {
+    CHECK(menu_data_index(s_data, cut, records, MENU_MAX_LEVELS) == 0);
+  }
+
+  uint8_t bad[MAX_SIZE];
+  memcpy(bad, s_data, size);
+  bad[2] = MENU_VERSION + 1;
+  CHECK(menu_data_num_levels(bad, size) == 0);
+
+  // A label length reaching past the end of the data
+  memcpy(bad, s_data, size);
+  bad[MENU_HEADER_SIZE + 1 + 2] = 0xff;
+  CHECK(menu_data_index(bad, size, records, MENU_MAX_LEVELS) == 0);
+}
+
+static void test_hash() {
+  const size_t size = menu_gen_definition(s_data, MAX_SIZE, 10, VibrationTypeCount);
+  const uint32_t hash = menu_data_hash(s_data, size, MENU_DATA_HASH_SEED);
+  CHECK(hash == menu_data_hash(s_data, size, MENU_DATA_HASH_SEED));
+  s_data[size - 1] ^= 1;
+  CHECK(hash != menu_data_hash(s_data, size, MENU_DATA_HASH_SEED));
+}
+
+static size_t write_chain(uint8_t *data, int num_levels) {
+  // One action at the bottom, then each level holding only the one before
+  size_t offset = MENU_HEADER_SIZE;
+  for(int l = 0; l < num_levels; l++) {
+    const uint8_t item[] = { 1, (l == 0) ? MenuItemKindAction : MenuItemKindChild, (l == 0) ? 0 : l - 1,
+                             2, 'x', '\0' };
+    memcpy(&data[offset], item, sizeof(item));
+    offset += sizeof(item);
+  }
+  menu_data_write_header(data, num_levels);
+  return offset;
+}
+
+static bool validate(const uint8_t *data, size_t size) {
+  return menu_data_validate(data, size, VibrationTypeCount, MenuCommandCount, MENU_MAX_DEPTH);
+}
+
+static void test_validate() {
+  size_t size = menu_gen_definition(s_data, MAX_SIZE, 100, VibrationTypeCount);
+  CHECK(validate(s_data, size));
+
+  // Item 0 of level 0, and the root's first item
+  uint8_t bad[MAX_SIZE];
+  const size_t first_item = MENU_HEADER_SIZE + 1;
+  size_t root_length;
+  const size_t root_item = menu_data_find_record(s_data, size, menu_data_num_levels(s_data, size) - 1,
+                                                 &root_length) - s_data + 1;
+
+  memcpy(bad, s_data, size);
+  bad[first_item + 1] = VibrationTypeCount;
+  CHECK(!validate(bad, size));
+
+  memcpy(bad, s_data, size);
+  bad[first_item] = MenuItemKindCommand;
+  bad[first_item + 1] = MenuCommandCount;
+  CHECK(!validate(bad, size));
+  bad[first_item + 1] = MenuCommandCount - 1;
+  CHECK(validate(bad, size));
+
+  memcpy(bad, s_data, size);
+  bad[first_item] = 7;
+  CHECK(!validate(bad, size));
+
+  // Children must come before their parent
+  memcpy(bad, s_data, size);
+  bad[root_item + 1] = menu_data_num_levels(s_data, size) - 1;
+  CHECK(!validate(bad, size));
+
+  // Labels must be terminated
+  memcpy(bad, s_data, size);
+  bad[first_item + MENU_ITEM_HEADER_SIZE + bad[first_item + 2] - 1] = 'x';
+  CHECK(!validate(bad, size));
+
+  // A chain of MENU_MAX_DEPTH + 1 levels reaches exactly MENU_MAX_DEPTH below the root
+  size = write_chain(bad, MENU_MAX_DEPTH + 1);
+  CHECK(validate(bad, size));
+  size = write_chain(bad, MENU_MAX_DEPTH + 2);
+  CHECK(!validate(bad, size));
+}
+
+static void test_resource() {
+  // The definition the app ships with
+  FILE *file = fopen("../resources/menu.bin", "rb");
+  CHECK(file != NULL);
+  if(file) {
+    const size_t size = fread(s_data, 1, MAX_SIZE, file);
+    fclose(file);
+    CHECK(validate(s_data, size));
+  }
+}
+
+int main() {
+  test_index();
+  test_malformed();
+  test_hash();
+  test_validate();
+  test_resource();
+  return TEST_RESULT();
+}
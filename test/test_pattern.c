@@ -0,0 +1,107 @@
+/**
+ * test_pattern.c - Expansion and scaling of every vibration type's pattern
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "config.h"
+#include "pattern.h"
+#include "test.h"
+#include "vibration_types.h"
+
+#define PATTERN_SPEC(name, label, play, on, off, count) \
+  [VibrationType##name] = { .on_ms = on, .off_ms = off, .repeat = count },
+
+static const PatternSpec s_specs[VibrationTypeCount] = {
+  VIBRATION_TYPES(PATTERN_SPEC)
+};
+
+static uint32_t expand(const PatternSpec *spec, uint32_t *segments) {
+  const uint32_t num_segments = pattern_expand(spec, segments, PATTERN_MAX_SEGMENTS);
+  CHECK(num_segments <= PATTERN_MAX_SEGMENTS);
+
+  // Starts and ends with a pulse, with nothing of zero length in between
+  CHECK(num_segments == 0 || num_segments % 2 == 1);
+  for(uint32_t i = 0; i < num_segments; i++) {
+    CHECK(segments[i] > 0);
+  }
+  return num_segments;
+}
+
+static bool equals(const uint32_t *segments, uint32_t num_segments, const uint32_t *expected,
+                   uint32_t num_expected) {
+  if(num_segments != num_expected) {
+    return false;
+  }
+  for(uint32_t i = 0; i < num_segments; i++) {
+    if(segments[i] != expected[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_every_type() {
+  for(int t = 0; t < VibrationTypeCount; t++) {
+    const PatternSpec *spec = &s_specs[t];
+    uint32_t segments[PATTERN_MAX_SEGMENTS];
+
+    const uint32_t num_full = expand(spec, segments);
+    CHECK(num_full > 0);
+    CHECK(pattern_on_time_ms(segments, num_full) == (uint32_t)spec->on_ms * spec->repeat);
+    CHECK(pattern_duration_ms(segments, num_full) ==
+          (uint32_t)spec->on_ms * spec->repeat + (uint32_t)spec->off_ms * (spec->repeat - 1));
+
+    const PatternSpec reduced = pattern_scale(spec, PatternPowerReduced, BATTERY_SAVER_SCALE_PERCENT);
+    CHECK(reduced.repeat == spec->repeat);
+    CHECK(reduced.on_ms <= spec->on_ms && reduced.off_ms <= spec->off_ms);
+    const uint32_t num_reduced = expand(&reduced, segments);
+    CHECK(num_reduced == num_full);
+    CHECK(pattern_on_time_ms(segments, num_reduced) < (uint32_t)spec->on_ms * spec->repeat);
+
+    const PatternSpec minimal = pattern_scale(spec, PatternPowerMinimal, BATTERY_SAVER_SCALE_PERCENT);
+    CHECK(expand(&minimal, segments) == 1);
+    CHECK(segments[0] == reduced.on_ms);
+
+    const PatternSpec full = pattern_scale(spec, PatternPowerFull, BATTERY_SAVER_SCALE_PERCENT);
+    CHECK(full.on_ms == spec->on_ms && full.off_ms == spec->off_ms && full.repeat == spec->repeat);
+  }
+}
+
+static void test_contents() {
+  uint32_t segments[PATTERN_MAX_SEGMENTS];
+
+  const uint32_t medium[] = { 200, 200, 200, 200, 200 };
+  CHECK(equals(segments, expand(&s_specs[VibrationTypeCustomMedium], segments), medium, 5));
+
+  const uint32_t long_pulse[] = { 500 };
+  CHECK(equals(segments, expand(&s_specs[VibrationTypeLong], segments), long_pulse, 1));
+
+  // Pulses without gaps merge into one
+  const PatternSpec merged = { .on_ms = 100, .off_ms = 0, .repeat = 3 };
+  const uint32_t merged_segments[] = { 300 };
+  CHECK(equals(segments, expand(&merged, segments), merged_segments, 1));
+
+  // No pulse at all gives nothing to play
+  const PatternSpec silent = { .on_ms = 0, .off_ms = 100, .repeat = 3 };
+  CHECK(expand(&silent, segments) == 0);
+}
+
+static void test_truncation() {
+  // Cut short on a whole pulse, never leaving a gap at the end
+  const PatternSpec many = { .on_ms = 50, .off_ms = 50, .repeat = 20 };
+  uint32_t segments[PATTERN_MAX_SEGMENTS];
+  CHECK(expand(&many, segments) == PATTERN_MAX_SEGMENTS - 1);
+
+  uint32_t few[4];
+  CHECK(pattern_expand(&many, few, 4) == 3);
+  CHECK(pattern_expand(&many, few, 1) == 1);
+}
+
+int main() {
+  test_every_type();
+  test_contents();
+  test_truncation();
+  return TEST_RESULT();
+}
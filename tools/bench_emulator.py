@@ -0,0 +1,221 @@
+#!/usr/bin/env python
+#
+# bench_emulator.py - Builds the app with its instrumentation switched on,
+# runs it in the emulator for each target platform, drives the menu with
+# button presses and prints the timings and heap figures from the app log.
+#
+# Usage: python tools/bench_emulator.py [--platforms aplite,basalt,chalk]
+#                                       [--cycles N] [--save results.json]
+#                                       [--baseline results.json]
+#
+# Needs the pebble tool on the PATH. The app's own launch benchmark
+# (BENCHMARK_MENU) runs first, then each cycle opens the menu, moves down
+# it and chooses, with DEBUG_HEAP and PROFILE_FRAMES logging throughout.
+# A cycle ends once the app logs that the menu closed, so the next one starts
+# from the main Window. Pressing BACK at the end exits the app so the profiler
+# summary is logged.
+# With --baseline, each metric is shown next to the saved value and the
+# change, so regressions stand out.
+#
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import threading
+import time
+
+ROOT_DIR = os.path.join(os.path.dirname(__file__), '..')
+
+PLATFORMS = ['aplite', 'basalt', 'chalk']
+
+APP_DEFINES = 'DEBUG_HEAP=1 BENCHMARK_MENU=1 PROFILE_FRAMES=1'
+
+# The ActionMenu animates in and out, give each press time to settle
+PRESS_DELAY_S = 0.6
+
+# Buttons pressed per cycle, opening the menu and choosing the second item
+CYCLE_BUTTONS = ['select', 'down', 'down', 'up', 'select']
+
+# Most BACK presses needed to close the menu if the choice opened a level
+MAX_BACKS = 4
+
+BENCH_TIMEOUT_S = 120
+CLOSE_TIMEOUT_S = 3
+SUMMARY_TIMEOUT_S = 15
+
+BENCH_RE = re.compile(r'bench: (\w+) (open|close|draw) n=(\d+) min=(\d+)ms median=(\d+)ms p95=(\d+)ms')
+LAYOUT_RE = re.compile(r'bench: (\w+) layout (\d+)ms')
+HEAP_RE = re.compile(r'heap: (\w+) used=(\d+) free=(\d+) peak=(\d+) stack=(\d+) peak_stack=(\d+)')
+CLOSE_RE = re.compile(r'heap: close ')
+SUMMARY_RE = re.compile(r'profile: frames=(\d+) mean=(\d+)ms max=(\d+)ms dropped=(\d+) '
+                        r'opens=(\d+) closes=(\d+) mean_open=(\d+)ms')
+
+
+class LogReader(object):
+    # Installs the app and collects its log on a background thread, from before
+    # it launches so nothing logged at startup is missed
+
+    def __init__(self, platform):
+        self.lines = []
+        self.lock = threading.Lock()
+        self.process = subprocess.Popen(['pebble', 'install', '--logs', '--emulator', platform], cwd=ROOT_DIR,
+                                        stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                        universal_newlines=True)
+        self.thread = threading.Thread(target=self.read)
+        self.thread.daemon = True
+        self.thread.start()
+
+    def read(self):
+        for line in self.process.stdout:
+            with self.lock:
+                self.lines.append(line.rstrip())
+
+    def count(self, pattern):
+        with self.lock:
+            return sum(1 for line in self.lines if pattern.search(line))
+
+    def wait_for(self, pattern, timeout, count=1):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            if self.count(pattern) >= count:
+                return True
+            time.sleep(0.2)
+        return False
+
+    def stop(self):
+        self.process.terminate()
+        self.process.wait()
+        with self.lock:
+            return list(self.lines)
+
+
+def run(args):
+    subprocess.check_call(args, cwd=ROOT_DIR)
+
+
+def press(platform, button):
+    run(['pebble', 'emu-button', 'click', button, '--emulator', platform])
+    time.sleep(PRESS_DELAY_S)
+
+
+def parse(lines):
+    results = {}
+    heap_peak = stack_peak = 0
+    for line in lines:
+        match = BENCH_RE.search(line)
+        if match:
+            name = match.group(2)
+            results[name + ' median ms'] = int(match.group(5))
+            results[name + ' p95 ms'] = int(match.group(6))
+            continue
+        match = LAYOUT_RE.search(line)
+        if match:
+            results['layout ms'] = int(match.group(2))
+            continue
+        match = HEAP_RE.search(line)
+        if match:
+            event, used = match.group(1), int(match.group(2))
+            heap_peak = max(heap_peak, int(match.group(4)))
+            stack_peak = max(stack_peak, int(match.group(6)))
+            if event not in ('open', 'action'):
+                # Resting usage, the last close shows what the menu leaves behind
+                results['heap after %s B' % event] = used
+            continue
+        match = SUMMARY_RE.search(line)
+        if match:
+            results['frames'] = int(match.group(1))
+            results['frame mean ms'] = int(match.group(2))
+            results['frame max ms'] = int(match.group(3))
+            results['dropped frames'] = int(match.group(4))
+            results['menu opens'] = int(match.group(5))
+            results['mean open ms'] = int(match.group(7))
+    if heap_peak:
+        results['heap peak B'] = heap_peak
+        results['stack peak B'] = stack_peak
+    return results
+
+
+def run_cycle(platform, reader):
+    closes = reader.count(CLOSE_RE)
+    for button in CYCLE_BUTTONS:
+        press(platform, button)
+
+    # Choosing a level rather than an action leaves the menu open, back out of
+    # it one press at a time so BACK never reaches the main Window
+    backs = 0
+    while not reader.wait_for(CLOSE_RE, CLOSE_TIMEOUT_S, closes + 1):
+        if backs == MAX_BACKS:
+            sys.stderr.write('%s: menu did not close\n' % platform)
+            return
+        press(platform, 'back')
+        backs += 1
+
+
+def bench_platform(platform, cycles):
+    reader = LogReader(platform)
+    try:
+        # The launch benchmark drives the menu itself, so wait for it to finish
+        if not reader.wait_for(re.compile(r'bench: \w+ close '), BENCH_TIMEOUT_S):
+            sys.stderr.write('%s: launch benchmark did not finish\n' % platform)
+
+        for _ in range(cycles):
+            run_cycle(platform, reader)
+
+        # Every cycle leaves the menu closed, so this exits the app
+        press(platform, 'back')
+        if not reader.wait_for(SUMMARY_RE, SUMMARY_TIMEOUT_S):
+            sys.stderr.write('%s: no profiler summary, did the app exit?\n' % platform)
+    finally:
+        lines = reader.stop()
+    return parse(lines)
+
+
+def print_table(platform, results, baseline):
+    print('')
+    print('== %s ==' % platform)
+    if baseline is None:
+        print('%-24s %10s' % ('metric', 'value'))
+    else:
+        print('%-24s %10s %10s %10s' % ('metric', 'value', 'baseline', 'change'))
+    for name in sorted(results):
+        value = results[name]
+        if baseline is None:
+            print('%-24s %10d' % (name, value))
+        elif name in baseline:
+            print('%-24s %10d %10d %+10d' % (name, value, baseline[name], value - baseline[name]))
+        else:
+            print('%-24s %10d %10s %10s' % (name, value, '-', '-'))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Benchmark the app in the emulator')
+    parser.add_argument('--platforms', default=','.join(PLATFORMS))
+    parser.add_argument('--cycles', type=int, default=10)
+    parser.add_argument('--save', help='write the results to this JSON file')
+    parser.add_argument('--baseline', help='compare against results saved with --save')
+    args = parser.parse_args(argv[1:])
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    env = dict(os.environ, APP_DEFINES=APP_DEFINES)
+    subprocess.check_call(['pebble', 'build'], cwd=ROOT_DIR, env=env)
+
+    all_results = {}
+    for platform in args.platforms.split(','):
+        all_results[platform] = bench_platform(platform, args.cycles)
+        print_table(platform, all_results[platform], baseline.get(platform, {}) if args.baseline else None)
+
+    if args.save:
+        with open(args.save, 'w') as f:
+            json.dump(all_results, f, indent=2, sort_keys=True)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,37 @@
+#!/usr/bin/env python
+#
+# gen_js_names.py - Writes the vibration type and menu command names, in enum
+# order, as JavaScript arrays for src/js/pebble-js-app.js. The wscript runs it
+# on every build, so the phone numbers items by the same X-macro lists in
+# src/vibration_types.h and src/menu_commands.h as the watch and
+# tools/pack_menu.py.
+#
+# Usage: python tools/gen_js_names.py build/src/js/menu_names.js
+#
+
+import sys
+
+from pack_menu import MENU_COMMANDS, VIBRATION_TYPES
+
+
+def js_array(name, header, names):
+    lines = ['// In the order of the X-macro list in src/%s' % header,
+             'var %s = [' % name]
+    lines += ["  '%s'," % n for n in names[:-1]] + ["  '%s'" % names[-1], '];']
+    return '\n'.join(lines)
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write('usage: %s <menu_names.js>\n' % argv[0])
+        return 1
+
+    with open(argv[1], 'w') as f:
+        f.write('// Generated by tools/gen_js_names.py, do not edit\n\n')
+        f.write(js_array('VIBRATION_TYPES', 'vibration_types.h', VIBRATION_TYPES) + '\n\n')
+        f.write(js_array('MENU_COMMANDS', 'menu_commands.h', MENU_COMMANDS) + '\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,152 @@
+#!/usr/bin/env python
+#
+# pack_icons.py - Packs the icons in resources/icons/ into the ICON_ATLAS
+# bitmap resource read by src/icon_atlas.c.
+#
+# Usage: python tools/pack_icons.py resources/icons resources/icon_atlas.png
+#
+# Icons are placed left to right, top aligned, in the order of the ICONS list
+# in src/icons.h. Each X(Name, width, height) entry is read from the file
+# <name in lower case>.png, which must be exactly that size. Only 8-bit,
+# non-interlaced PNGs are supported, and the atlas is written as RGBA.
+#
+
+import os
+import re
+import struct
+import sys
+import zlib
+
+SRC_DIR = os.path.join(os.path.dirname(__file__), '..', 'src')
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+
+# Channels per pixel for each supported PNG colour type
+CHANNELS = {0: 1, 2: 3, 4: 2, 6: 4}
+
+
+def read_icons():
+    # (name, width, height) in Icon order, from the X-macro list
+    with open(os.path.join(SRC_DIR, 'icons.h')) as f:
+        return [(name, int(w), int(h)) for name, w, h in
+                re.findall(r'^\s*X\((\w+),\s*(\d+),\s*(\d+)\)', f.read(), re.MULTILINE)]
+
+
+def read_chunks(data):
+    if data[:8] != PNG_SIGNATURE:
+        raise ValueError('not a PNG')
+    offset = 8
+    while offset < len(data):
+        length, kind = struct.unpack('>I4s', data[offset:offset + 8])
+        yield kind, data[offset + 8:offset + 8 + length]
+        offset += length + 12
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(raw, width, height, bpp):
+    rows = []
+    stride = width * bpp
+    prev = bytearray(stride)
+    offset = 0
+    for _ in range(height):
+        kind = raw[offset]
+        row = bytearray(raw[offset + 1:offset + 1 + stride])
+        offset += 1 + stride
+        for i in range(stride):
+            left = row[i - bpp] if i >= bpp else 0
+            up = prev[i]
+            up_left = prev[i - bpp] if i >= bpp else 0
+            if kind == 1:
+                row[i] = (row[i] + left) & 0xff
+            elif kind == 2:
+                row[i] = (row[i] + up) & 0xff
+            elif kind == 3:
+                row[i] = (row[i] + (left + up) // 2) & 0xff
+            elif kind == 4:
+                row[i] = (row[i] + paeth(left, up, up_left)) & 0xff
+        rows.append(row)
+        prev = row
+    return rows
+
+
+def to_rgba(row, channels):
+    out = bytearray()
+    for i in range(0, len(row), channels):
+        px = row[i:i + channels]
+        if channels == 1:
+            out += bytes((px[0], px[0], px[0], 255))
+        elif channels == 2:
+            out += bytes((px[0], px[0], px[0], px[1]))
+        elif channels == 3:
+            out += px + b'\xff'
+        else:
+            out += px
+    return out
+
+
+def read_png(path):
+    # Rows of RGBA bytes
+    with open(path, 'rb') as f:
+        data = f.read()
+    header, idat = None, b''
+    for kind, body in read_chunks(data):
+        if kind == b'IHDR':
+            header = struct.unpack('>IIBBBBB', body)
+        elif kind == b'IDAT':
+            idat += body
+    width, height, depth, color_type, _, _, interlace = header
+    if depth != 8 or interlace or color_type not in CHANNELS:
+        raise ValueError('%s: only 8-bit non-interlaced grey, RGB or RGBA PNGs are supported' % path)
+    channels = CHANNELS[color_type]
+    rows = unfilter(zlib.decompress(idat), width, height, channels)
+    return width, height, [to_rgba(row, channels) for row in rows]
+
+
+def write_chunk(kind, body):
+    return struct.pack('>I', len(body)) + kind + body + struct.pack('>I', zlib.crc32(kind + body) & 0xffffffff)
+
+
+def write_png(path, width, height, rows):
+    raw = b''.join(b'\0' + bytes(row) for row in rows)
+    with open(path, 'wb') as f:
+        f.write(PNG_SIGNATURE)
+        f.write(write_chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 6, 0, 0, 0)))
+        f.write(write_chunk(b'IDAT', zlib.compress(raw, 9)))
+        f.write(write_chunk(b'IEND', b''))
+
+
+def pack_icons(icon_dir, icons):
+    width = sum(w for _, w, _ in icons)
+    height = max(h for _, _, h in icons)
+    rows = [bytearray(width * 4) for _ in range(height)]
+    x = 0
+    for name, w, h in icons:
+        path = os.path.join(icon_dir, name.lower() + '.png')
+        icon_w, icon_h, icon_rows = read_png(path)
+        if (icon_w, icon_h) != (w, h):
+            raise ValueError('%s is %dx%d, src/icons.h says %dx%d' % (path, icon_w, icon_h, w, h))
+        for y, row in enumerate(icon_rows):
+            rows[y][x * 4:(x + w) * 4] = row
+        x += w
+    return width, height, rows
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('usage: %s <icon dir> <atlas.png>\n' % argv[0])
+        return 1
+
+    width, height, rows = pack_icons(argv[1], read_icons())
+    write_png(argv[2], width, height, rows)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
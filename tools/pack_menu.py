@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+#
+# pack_menu.py - Packs a JSON menu description into the binary MENU resource
+# read by src/menu.c and validated by src/menu_data.c.
+#
+# Usage: python tools/pack_menu.py resources/menu.json resources/menu.bin
+#
+# Layout (all fields are single bytes):
+#
+#   header:  'A' 'M' <version> <level count>
+#   level:   <item count> <item>...
+#   item:    <kind> <value> <label length> <label bytes, NUL terminated>
+#
+# An item of kind 0 is an action and its value is a VibrationType, an item of
+# kind 1 is a child level and its value is the index of that level's record,
+# and an item of kind 2 is a MenuCommand. Actions and commands without a label
+# are written with a label length of 0 and shown with their default label from
+# src/vibration_types.h or src/menu_commands.h.
+# Levels are written children first so a single pass can build the hierarchy,
+# which means the root level is always the last record.
+#
+
+import json
+import os
+import re
+import struct
+import sys
+
+MAGIC = b'AM'
+VERSION = 1
+
+KIND_ACTION = 0
+KIND_CHILD = 1
+KIND_COMMAND = 2
+
+SRC_DIR = os.path.join(os.path.dirname(__file__), '..', 'src')
+
+
+def read_x_macro_names(header):
+    # Entry names in enum order, from an X-macro list
+    with open(os.path.join(SRC_DIR, header)) as f:
+        return re.findall(r'^\s*X\((\w+),', f.read(), re.MULTILINE)
+
+
+VIBRATION_TYPES = read_x_macro_names('vibration_types.h')
+MENU_COMMANDS = read_x_macro_names('menu_commands.h')
+
+
+def pack_level(level, records):
+    items = level['items']
+    if not 0 < len(items) < 256:
+        raise ValueError('a level must have between 1 and 255 items')
+
+    out = struct.pack('B', len(items))
+    for item in items:
+        if 'items' in item:
+            kind, value = KIND_CHILD, pack_level(item, records)
+            label = item['label']
+        elif 'command' in item:
+            kind, value = KIND_COMMAND, MENU_COMMANDS.index(item['command'])
+            label = item.get('label')
+        else:
+            kind, value = KIND_ACTION, VIBRATION_TYPES.index(item['type'])
+            label = item.get('label')
+
+        label = label.encode('utf-8') + b'\0' if label else b''
+        if len(label) > 255:
+            raise ValueError('label too long: %s' % item['label'])
+        out += struct.pack('BBB', kind, value, len(label)) + label
+
+    records.append(out)
+    if len(records) > 255:
+        raise ValueError('too many levels')
+    return len(records) - 1
+
+
+def pack_menu(menu):
+    records = []
+    pack_level(menu, records)
+    return MAGIC + struct.pack('BB', VERSION, len(records)) + b''.join(records)
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('usage: %s <menu.json> <menu.bin>\n' % argv[0])
+        return 1
+
+    with open(argv[1]) as f:
+        data = pack_menu(json.load(f))
+    with open(argv[2], 'wb') as f:
+        f.write(data)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,110 @@
+/**
+ * job_queue.c - Coalescing by lateness: the timer is set for the earliest
+ * deadline, and every job already due by then runs with it
+ */
+
+#include "job_queue.h"
+
+static void remove_job(JobQueue *queue, int index) {
+  // Order doesn't matter, jobs are always searched by due time
+  queue->jobs[index] = queue->jobs[--queue->num_jobs];
+}
+
+static time_t get_deadline(const Job *job) {
+  uint32_t lateness_s = job->interval_s / JOB_QUEUE_LATENESS_DIVISOR;
+  if(lateness_s > JOB_QUEUE_MAX_LATENESS_S) {
+    lateness_s = JOB_QUEUE_MAX_LATENESS_S;
+  }
+  return job->due + lateness_s;
+}
+
+void job_queue_add(JobQueue *queue, uint16_t type, uint16_t interval_s, uint16_t count, time_t now) {
+  if(interval_s == 0) {
+    return;
+  }
+
+  for(int i = 0; i < queue->num_jobs; i++) {
+    if(queue->jobs[i].type == type) {
+      remove_job(queue, i);
+      break;
+    }
+  }
+  if(queue->num_jobs == WORKER_MAX_JOBS) {
+    int oldest = 0;
+    for(int i = 1; i < queue->num_jobs; i++) {
+      if(queue->jobs[i].due < queue->jobs[oldest].due) {
+        oldest = i;
+      }
+    }
+    remove_job(queue, oldest);
+  }
+
+  queue->jobs[queue->num_jobs++] = (Job) {
+    .type = type,
+    .interval_s = interval_s,
+    .remaining = count,
+    .due = now + interval_s,
+  };
+}
+
+void job_queue_clear(JobQueue *queue) {
+  queue->num_jobs = 0;
+}
+
+void job_queue_remove_shorter(JobQueue *queue, uint16_t min_interval_s) {
+  for(int i = 0; i < queue->num_jobs; i++) {
+    if(queue->jobs[i].interval_s < min_interval_s) {
+      remove_job(queue, i--);
+    }
+  }
+}
+
+bool job_queue_next_fire(const JobQueue *queue, time_t *fire_at) {
+  if(queue->num_jobs == 0) {
+    return false;
+  }
+
+  time_t earliest = get_deadline(&queue->jobs[0]);
+  for(int i = 1; i < queue->num_jobs; i++) {
+    const time_t deadline = get_deadline(&queue->jobs[i]);
+    if(deadline < earliest) {
+      earliest = deadline;
+    }
+  }
+  *fire_at = earliest;
+  return true;
+}
+
+int job_queue_take_due(JobQueue *queue, time_t now, uint16_t *types) {
+  // A type has at most one job, so each due job is a distinct type
+  int num_due = 0;
+  time_t dues[WORKER_MAX_JOBS];
+  for(int i = 0; i < queue->num_jobs; i++) {
+    Job *job = &queue->jobs[i];
+    if(job->due > now) {
+      continue;
+    }
+
+    int j = num_due++;
+    for(; j > 0 && dues[j - 1] > job->due; j--) {
+      dues[j] = dues[j - 1];
+      types[j] = types[j - 1];
+    }
+    dues[j] = job->due;
+    types[j] = job->type;
+
+    if(job->remaining == 1) {
+      remove_job(queue, i--);
+      continue;
+    }
+    if(job->remaining > 1) {
+      job->remaining--;
+    }
+
+    // Keep to the original cadence rather than drifting by however late this ran
+    while(job->due <= now) {
+      job->due += job->interval_s;
+    }
+  }
+  return num_due;
+}
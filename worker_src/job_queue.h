@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * job_queue.h - Repeating and one-off vibration jobs ordered by due time.
+ * Each job may run a little late, so jobs falling due close together are
+ * merged behind a single timer instead of waking the watch once per job.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../src/worker_protocol.h"
+
+// How late a job may run, as a fraction of its interval and at most this long
+#define JOB_QUEUE_LATENESS_DIVISOR 4
+#define JOB_QUEUE_MAX_LATENESS_S 30
+
+typedef struct {
+  uint16_t type;
+  uint16_t interval_s;
+  uint16_t remaining;          // 0 repeats until cancelled
+  time_t due;
+} Job;
+
+typedef struct {
+  Job jobs[WORKER_MAX_JOBS];
+  int num_jobs;
+} JobQueue;
+
+// First due interval_s from now, replacing any job of the same type and the
+// oldest job if the queue is full
+void job_queue_add(JobQueue *queue, uint16_t type, uint16_t interval_s, uint16_t count, time_t now);
+
+void job_queue_clear(JobQueue *queue);
+
+// Drop every job that repeats more often than every min_interval_s
+void job_queue_remove_shorter(JobQueue *queue, uint16_t min_interval_s);
+
+// When the single timer should fire, the latest time no job runs too late.
+// Returns false if the queue is empty.
+bool job_queue_next_fire(const JobQueue *queue, time_t *fire_at);
+
+// Take every job due by now, rescheduling repeats. Writes their types to
+// types, which has room for WORKER_MAX_JOBS, in the order they fell due and
+// returns how many there are.
+int job_queue_take_due(JobQueue *queue, time_t now, uint16_t *types);
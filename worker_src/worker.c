@@ -0,0 +1,123 @@
+/**
+ * worker.c - Background worker holding the scheduled vibration jobs behind a
+ * single timer. While the app is attached each due job is sent to it to play,
+ * otherwise the due jobs are left in persistent storage and the app is
+ * launched.
+ */
+
+#include <pebble_worker.h>
+
+#include "../src/persist_keys.h"
+#include "../src/worker_protocol.h"
+#include "job_queue.h"
+
+static JobQueue s_queue;
+static AppTimer *s_timer;
+static bool s_app_attached;
+
+static void timer_callback(void *context);
+
+/************************************ Jobs ************************************/
+
+static void update_timer() {
+  // Every job rides on the one timer, set for the first deadline
+  if(s_timer) {
+    app_timer_cancel(s_timer);
+    s_timer = NULL;
+  }
+
+  time_t fire_at;
+  if(job_queue_next_fire(&s_queue, &fire_at)) {
+    const time_t now = time(NULL);
+    const uint32_t delay_ms = (fire_at > now) ? (fire_at - now) * 1000 : 0;
+    s_timer = app_timer_register(delay_ms, timer_callback, NULL);
+  }
+}
+
+static void leave_pending(const uint16_t *types, int num_types) {
+  // Added to anything the app hasn't picked up yet, without repeating a type
+  uint8_t pending[WORKER_MAX_JOBS];
+  int num_pending = persist_exists(PersistKeyWorkerPendingTypes) ?
+                    persist_read_data(PersistKeyWorkerPendingTypes, pending, sizeof(pending)) : 0;
+  if(num_pending < 0) {
+    num_pending = 0;
+  }
+
+  for(int i = 0; i < num_types && num_pending < WORKER_MAX_JOBS; i++) {
+    bool found = false;
+    for(int j = 0; j < num_pending && !found; j++) {
+      found = (pending[j] == types[i]);
+    }
+    if(!found) {
+      pending[num_pending++] = types[i];
+    }
+  }
+  persist_write_data(PersistKeyWorkerPendingTypes, pending, num_pending);
+}
+
+static void play_jobs(const uint16_t *types, int num_types) {
+  if(s_app_attached) {
+    // The app spaces them out, so each can be told apart
+    for(int i = 0; i < num_types; i++) {
+      AppWorkerMessage message = { .data0 = types[i] };
+      app_worker_send_message(WorkerMessagePlay, &message);
+    }
+  } else {
+    leave_pending(types, num_types);
+    worker_launch_app();
+  }
+}
+
+static void timer_callback(void *context) {
+  s_timer = NULL;
+
+  // Jobs merged into this wakeup share it, but each still plays
+  uint16_t types[WORKER_MAX_JOBS];
+  const int num_types = job_queue_take_due(&s_queue, time(NULL), types);
+  if(num_types > 0) {
+    play_jobs(types, num_types);
+  }
+  update_timer();
+}
+
+/********************************** Messages **********************************/
+
+static void message_handler(uint16_t type, AppWorkerMessage *message) {
+  switch(type) {
+    case WorkerMessageAttach:
+      s_app_attached = true;
+      break;
+    case WorkerMessageDetach:
+      s_app_attached = false;
+      job_queue_remove_shorter(&s_queue, WORKER_MIN_DETACHED_INTERVAL_S);
+      update_timer();
+      break;
+    case WorkerMessageSchedule:
+      job_queue_add(&s_queue, message->data0, message->data1, message->data2, time(NULL));
+      update_timer();
+      break;
+  }
+}
+
+/*********************************** Worker ***********************************/
+
+static void init() {
+  app_worker_message_subscribe(message_handler);
+
+  // The app may be waiting to hear the worker is up before sending jobs
+  AppWorkerMessage message = { 0 };
+  app_worker_send_message(WorkerMessageReady, &message);
+}
+
+static void deinit() {
+  if(s_timer) {
+    app_timer_cancel(s_timer);
+  }
+  app_worker_message_unsubscribe();
+}
+
+int main() {
+  init();
+  worker_event_loop();
+  deinit();
+}